@@ -186,6 +186,32 @@ PYBIND11_MODULE(pylibjodi, module)
                                   BytesToPyBytes(eval.vk));
         }, py::arg("privk"), py::arg("publk"), py::arg("x"))
 
+        .def_static("evaluate_batch", [](const py::bytes& privk,
+                                         const py::bytes& publk,
+                                         const std::vector<py::bytes>& xs) {
+            Bytes sk = PyBytesToBytes(privk);
+            Bytes pk = PyBytesToBytes(publk);
+
+            std::vector<Bytes> in_xs;
+            in_xs.reserve(xs.size());
+            for (const auto& x : xs) {
+                in_xs.push_back(PyBytesToBytes(x));
+            }
+
+            OPRF_BatchEval batch;
+            {
+                py::gil_scoped_release release;
+                OPRF_Keypair keypair(sk, pk);
+                batch = OPRF::EvaluateBatch(keypair, in_xs);
+            }
+
+            py::list fxs;
+            for (size_t i = 0; i < batch.Size(); i++) {
+                fxs.append(BytesToPyBytes(batch.Get(i)));
+            }
+            return py::make_tuple(fxs, BytesToPyBytes(batch.vk));
+        }, py::arg("privk"), py::arg("publk"), py::arg("xs"))
+
         .def_static("unblind", [](const py::bytes& fx,
                                   const py::bytes& vk,
                                   const py::bytes& r) {
@@ -213,6 +239,19 @@ PYBIND11_MODULE(pylibjodi, module)
             }
         }, py::arg("size"), py::arg("interval"))
 
+        .def("start_deterministic_rotation", [](KeyRotation &self, int size, int interval, py::bytes seed, int64_t genesis) {
+            Bytes masterSeed = PyBytesToBytes(seed);
+            {
+                py::gil_scoped_release release;
+                self.StartRotation(size, interval, masterSeed, genesis);
+            }
+        }, py::arg("size"), py::arg("interval"), py::arg("seed"), py::arg("genesis") = 0)
+
+        .def("use_key_store", [](KeyRotation &self, const std::string &path) {
+            py::gil_scoped_release release;
+            self.UseKeyStore(path);
+        }, py::arg("path"))
+
         .def("stop_rotation", [](KeyRotation &self) {
             {
                 py::gil_scoped_release release;
@@ -327,7 +366,46 @@ PYBIND11_MODULE(pylibjodi, module)
                 valid = VOPRF::Verify(pk, msg_str, digest);
             }
             return valid;
-        }, py::arg("vk"), py::arg("msg"), py::arg("y"));
+        }, py::arg("vk"), py::arg("msg"), py::arg("y"))
+
+        .def_static("verify_batch", [](const py::bytes& vk, const std::vector<std::string>& msgs, const std::vector<py::bytes>& ys) {
+            PublicKey pk = PublicKey::FromBytes(PyBytesToBytes(vk));
+            vector<Point> points;
+            points.reserve(ys.size());
+            for (const auto& y : ys) {
+                points.push_back(Point::FromBytes(PyBytesToBytes(y)));
+            }
+
+            bool valid;
+            vector<size_t> failed;
+            {
+                py::gil_scoped_release release;
+                valid = VOPRF::VerifyBatch(pk, msgs, points, &failed);
+            }
+            return py::make_tuple(valid, failed);
+        }, py::arg("vk"), py::arg("msgs"), py::arg("ys"));
+
+    //
+    // Call ID generation
+    //
+    module.def("generate_call_id", [](const py::str& call_details, const std::vector<std::string>& servers) {
+        std::string details(call_details);
+
+        Bytes callId;
+        CallIdTimings timings;
+        {
+            py::gil_scoped_release release;
+            callId = GenerateCallId(details, servers, timings);
+        }
+
+        py::dict stages;
+        stages["blind_us"] = timings.blindUs;
+        stages["fanout_us"] = timings.fanoutUs;
+        stages["server_us"] = timings.serverUs;
+        stages["combine_us"] = timings.combineUs;
+        stages["total_us"] = timings.totalUs;
+        return py::make_tuple(BytesToPyBytes(callId), stages);
+    }, py::arg("call_details"), py::arg("servers"));
 
     // Module version
     #ifdef LIBJODI_VERSION
@@ -1,5 +1,7 @@
 #include <sodium.h>
 #include <chrono>
+#include <sstream>
+#include <thread>
 
 #include "../libjodi/libjodi.hpp"
 
@@ -30,6 +32,24 @@ void BenchBlinding() {
     endTimer("OPRF::Blind", start, numIters);
 }
 
+void BenchBlindingPool() {
+    OPRF_BlindingPool pool(2 * numIters, numIters / 2);
+    pool.Start();
+    while (pool.GetStats().available < pool.GetHighWatermark()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        auto blinded = OPRF::Blind(callDetails, pool);
+    }
+    endTimer("OPRF::Blind (precomputed pool)", start, numIters);
+
+    auto stats = pool.GetStats();
+    std::cout << "Pool misses: " << stats.misses << ", refills: " << stats.refills << std::endl;
+    pool.Stop();
+}
+
 void BenchEvaluation() {
     auto keypair = OPRF::Keygen();
     auto blinded = OPRF::Blind(callDetails);
@@ -41,6 +61,37 @@ void BenchEvaluation() {
     endTimer("OPRF::Evaluate", start, numIters);
 }
 
+void BenchEvaluationBatch() {
+    auto keypair = OPRF::Keygen();
+
+    vector<Bytes> xs;
+    for (auto i = 0; i < numIters; i++) {
+        xs.push_back(OPRF::Blind(callDetails).x);
+    }
+
+    auto start = startTimer();
+    auto batch = OPRF::EvaluateBatch(keypair, xs);
+    endTimer("OPRF::EvaluateBatch (" + std::to_string(WorkerPool::GetDefault().GetSize() + 1) + " threads)", start, numIters);
+}
+
+void BenchVerifiableBatch() {
+    auto keypair = OPRF::Keygen();
+
+    vector<Bytes> xs;
+    for (auto i = 0; i < numIters; i++) {
+        xs.push_back(OPRF::Blind(callDetails).x);
+    }
+
+    OPRF_Proof proof;
+    auto start = startTimer();
+    auto batch = OPRF::EvaluateBatch(keypair, xs, proof);
+    endTimer("OPRF::EvaluateBatch + DLEQ proof", start, numIters);
+
+    start = startTimer();
+    bool ok = OPRF::VerifyBatch(batch.vk, xs, batch, proof);
+    endTimer(string("OPRF::VerifyBatch (") + (ok ? "valid" : "INVALID") + ")", start, numIters);
+}
+
 void BenchUnblinding() {
     auto keypair = OPRF::Keygen();
     auto blinded = OPRF::Blind(callDetails);
@@ -53,6 +104,43 @@ void BenchUnblinding() {
     endTimer("OPRF::Unblind", start, numIters);
 }
 
+void BenchUnblindingPrepared() {
+    auto keypair = OPRF::Keygen();
+    auto blinded = OPRF::Blind(callDetails);
+    auto eval = OPRF::Evaluate(keypair, blinded.x);
+    PreparedOprfPublicKey vk(eval.vk);
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Bytes label = OPRF::Unblind(eval, vk, blinded.r);
+    }
+    endTimer("OPRF::Unblind (prepared key)", start, numIters);
+}
+
+void BenchFixedWidth() {
+    OPRF_Scalar sk, r;
+    OPRF_Element pk, x, fx, label;
+    OPRF::Keygen(sk, pk);
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        OPRF::Blind(callDetails, x, r);
+    }
+    endTimer("OPRF::Blind (fixed-width)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        OPRF::Evaluate(sk, x, fx);
+    }
+    endTimer("OPRF::Evaluate (fixed-width)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        OPRF::Unblind(fx, pk, r, label);
+    }
+    endTimer("OPRF::Unblind (fixed-width)", start, numIters);
+}
+
 void BenchEncryption() {
     Bytes key = Ciphering::Keygen();
     Bytes plaintext = Utils::RandomBytes(256); // 2KB
@@ -76,6 +164,139 @@ void BenchDecryption() {
     endTimer("Ciphering::Decrypt", start, numIters);
 }
 
+void BenchEncryptionInPlace() {
+    Bytes key = Ciphering::Keygen();
+    Bytes buf(Ciphering::CiphertextSize(256));
+    randombytes_buf(buf.data() + Ciphering::NONCE_SIZE, 256);
+    size_t written;
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Ciphering::Encrypt(key, buf.data() + Ciphering::NONCE_SIZE, 256, buf.data(), buf.size(), &written);
+        Ciphering::Decrypt(key, buf.data(), buf.size(), buf.data() + Ciphering::NONCE_SIZE, 256, &written);
+    }
+    endTimer("Ciphering::Encrypt + Decrypt in place", start, numIters);
+}
+
+void BenchCipherContext() {
+    Bytes key = Ciphering::Keygen();
+
+    vector<CipherAlgorithm> algorithms = {CipherAlgorithm::XChaCha20Poly1305};
+    if (CipherContext::IsAesAvailable()) {
+        algorithms.push_back(CipherAlgorithm::Aes256Gcm);
+    } else {
+        std::cout << std::endl << "CipherContext: no AES-GCM support on this CPU" << std::endl;
+    }
+
+    for (auto algorithm : algorithms) {
+        CipherContext ctx(key, algorithm);
+        string name = algorithm == CipherAlgorithm::Aes256Gcm ? "AES-256-GCM" : "XChaCha20-Poly1305";
+
+        for (size_t size : {64, 1024, 16 * 1024, 256 * 1024, 1024 * 1024}) {
+            // Keep the total work roughly constant across sizes
+            int iters = std::max(10, std::min(numIters, (int)(64 * 1024 * 1024 / size)));
+            Bytes plaintext = Utils::RandomBytes(size);
+            Bytes ciphertext(ctx.CiphertextSize(size));
+            Bytes decrypted(size);
+            size_t written;
+
+            auto start = startTimer();
+            for (auto i = 0; i < iters; i++) {
+                ctx.Encrypt(plaintext.data(), size, ciphertext.data(), ciphertext.size(), &written);
+            }
+            endTimer("CipherContext::Encrypt " + name + " (" + std::to_string(size) + " bytes)", start, iters);
+
+            start = startTimer();
+            for (auto i = 0; i < iters; i++) {
+                ctx.Decrypt(ciphertext.data(), ciphertext.size(), decrypted.data(), decrypted.size(), &written);
+            }
+            endTimer("CipherContext::Decrypt " + name + " (" + std::to_string(size) + " bytes)", start, iters);
+        }
+    }
+}
+
+void BenchCipherBatch() {
+    const size_t n = 10000;
+    vector<CipherBatchItem> items;
+    for (size_t i = 0; i < n; i++) {
+        items.emplace_back(Ciphering::Keygen(), Utils::RandomBytes(256));
+    }
+    const int iters = 10;
+
+    auto start = startTimer();
+    for (auto i = 0; i < iters; i++) {
+        for (const auto &item : items) {
+            Bytes ctx = Ciphering::Encrypt(item.first, item.second);
+        }
+    }
+    endTimer("Ciphering::Encrypt x " + std::to_string(n) + " (serial)", start, iters);
+
+    CipherBatch encrypted;
+    start = startTimer();
+    for (auto i = 0; i < iters; i++) {
+        encrypted = Ciphering::EncryptBatch(items);
+    }
+    endTimer("Ciphering::EncryptBatch x " + std::to_string(n), start, iters);
+
+    vector<CipherBatchItem> ciphertexts;
+    for (size_t i = 0; i < n; i++) {
+        ciphertexts.emplace_back(items[i].first, encrypted.Get(i));
+    }
+
+    start = startTimer();
+    for (auto i = 0; i < iters; i++) {
+        CipherBatch decrypted = Ciphering::DecryptBatch(ciphertexts);
+    }
+    endTimer("Ciphering::DecryptBatch x " + std::to_string(n), start, iters);
+}
+
+void BenchStreamEncryption() {
+    Bytes key = Ciphering::Keygen();
+    Bytes data = Utils::RandomBytes(8 * 1024 * 1024);
+    string payload(data.begin(), data.end());
+    const int iters = 10;
+
+    string ctx;
+    auto start = startTimer();
+    for (auto i = 0; i < iters; i++) {
+        std::istringstream in(payload);
+        std::ostringstream out;
+        Ciphering::EncryptStream(key, in, out);
+        ctx = out.str();
+    }
+    endTimer("Ciphering::EncryptStream (8 MB)", start, iters);
+
+    start = startTimer();
+    for (auto i = 0; i < iters; i++) {
+        std::istringstream in(ctx);
+        std::ostringstream out;
+        Ciphering::DecryptStream(key, in, out);
+    }
+    endTimer("Ciphering::DecryptStream (8 MB)", start, iters);
+}
+
+void BenchXor() {
+    std::cout << std::endl << "Utils::Xor kernel: " << Utils::XorKernel() << std::endl;
+
+    for (size_t size : {32, 1024, 64 * 1024, 1024 * 1024}) {
+        int iters = std::max(10, std::min(numIters, (int)(64 * 1024 * 1024 / size)));
+        Bytes x = Utils::RandomBytes(size);
+        Bytes y = Utils::RandomBytes(size);
+
+        auto start = startTimer();
+        for (auto i = 0; i < iters; i++) {
+            Bytes z = Utils::Xor(x, y);
+        }
+        endTimer("Utils::Xor (" + std::to_string(size) + " bytes)", start, iters);
+
+        start = startTimer();
+        for (auto i = 0; i < iters; i++) {
+            Utils::XorInto(x, y);
+        }
+        endTimer("Utils::XorInto (" + std::to_string(size) + " bytes)", start, iters);
+    }
+}
+
 void BenchVOPRF() {
     InitMCL();
 
@@ -110,6 +331,188 @@ void BenchVOPRF() {
         verified = VOPRF::Verify(pk, msg, y);
     }
     endTimer("VOPRF::Verify", start, numIters);
+
+    PreparedPublicKey prepared(pk);
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        verified = VOPRF::Verify(prepared, msg, y);
+    }
+    endTimer("VOPRF::Verify (prepared key)", start, numIters);
+}
+
+void BenchExecutionModes() {
+    InitMCL();
+
+    PrivateKey sk = PrivateKey::Keygen();
+    Point p = Point::HashToPoint(callDetails);
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Point q = Point::Mul(p, sk, ExecutionMode::SecretInputs);
+    }
+    endTimer("Point::Mul (SecretInputs, mulCT)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Point q = Point::Mul(p, sk, ExecutionMode::PublicInputs);
+    }
+    endTimer("Point::Mul (PublicInputs, mul)", start, numIters);
+}
+
+void BenchVOPRFBatch() {
+    InitMCL();
+
+    PrivateKey sk = PrivateKey::Keygen();
+    vector<string> msgs;
+    for (auto i = 0; i < numIters; i++) {
+        msgs.push_back(callDetails + std::to_string(i));
+    }
+
+    auto start = startTimer();
+    VOPRF_BlindedBatch blinded = VOPRF::BlindBatch(msgs);
+    endTimer("VOPRF::BlindBatch", start, numIters);
+
+    vector<Point> fxs;
+    for (const auto& x : blinded.xs) {
+        fxs.push_back(VOPRF::Evaluate(sk, x));
+    }
+
+    start = startTimer();
+    vector<Point> ys = VOPRF::UnblindBatch(fxs, blinded);
+    endTimer("VOPRF::UnblindBatch", start, numIters);
+}
+
+void BenchVOPRFVerifyBatch() {
+    InitMCL();
+
+    PrivateKey sk = PrivateKey::Keygen();
+    PublicKey pk = sk.GetPublicKey();
+
+    vector<string> msgs;
+    vector<Point> ys;
+    for (auto i = 0; i < numIters; i++) {
+        msgs.push_back(callDetails + std::to_string(i));
+        ys.push_back(VOPRF::Evaluate(sk, Point::HashToPoint(msgs.back())));
+    }
+
+    auto start = startTimer();
+    bool ok = VOPRF::VerifyBatch(pk, msgs, ys);
+    endTimer(string("VOPRF::VerifyBatch (") + (ok ? "valid" : "INVALID") + ")", start, numIters);
+}
+
+void BenchMulVec() {
+    InitMCL();
+
+    for (size_t n = 2; n <= 4096; n *= 2) {
+        vector<Point> points;
+        vector<PublicKey> keys;
+        vector<PrivateKey> scalars;
+        for (size_t i = 0; i < n; i++) {
+            points.push_back(Point::HashToPoint(callDetails + std::to_string(i)));
+            scalars.push_back(PrivateKey::Keygen());
+            keys.push_back(scalars.back().GetPublicKey());
+        }
+
+        int iters = std::max<int>(1, 4096 / (int)n);
+        string size = " (n=" + std::to_string(n) + ")";
+
+        auto start = startTimer();
+        for (auto it = 0; it < iters; it++) {
+            mcl::bn::G1 acc, term;
+            acc.clear();
+            for (size_t i = 0; i < n; i++) {
+                mcl::bn::G1::mul(term, points[i].GetG1(), scalars[i].GetFr());
+                mcl::bn::G1::add(acc, acc, term);
+            }
+        }
+        endTimer("G1 naive mul/add loop" + size, start, iters);
+
+        start = startTimer();
+        for (auto it = 0; it < iters; it++) {
+            Point sum = Point::MulVec(points, scalars);
+        }
+        endTimer("Point::MulVec" + size, start, iters);
+
+        start = startTimer();
+        for (auto it = 0; it < iters; it++) {
+            mcl::bn::G2 acc, term;
+            acc.clear();
+            for (size_t i = 0; i < n; i++) {
+                mcl::bn::G2::mul(term, keys[i].GetG2(), scalars[i].GetFr());
+                mcl::bn::G2::add(acc, acc, term);
+            }
+        }
+        endTimer("G2 naive mul/add loop" + size, start, iters);
+
+        start = startTimer();
+        for (auto it = 0; it < iters; it++) {
+            PublicKey sum = PublicKey::MulVec(keys, scalars);
+        }
+        endTimer("PublicKey::MulVec" + size, start, iters);
+    }
+}
+
+void BenchSerialization() {
+    InitMCL();
+
+    PublicKey pk = PrivateKey::Keygen().GetPublicKey();
+    Point p = Point::HashToPoint(callDetails);
+    Pairing e = Pairing::Pair(p, pk);
+    uint8_t buf[Pairing::SERIALIZED_SIZE];
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        string s = p.ToString();
+    }
+    endTimer("Point::ToString", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        p.SerializeTo(buf, sizeof(buf));
+    }
+    endTimer("Point::SerializeTo", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        string s = e.ToString();
+    }
+    endTimer("Pairing::ToString (" + std::to_string(e.ToString().size()) + " bytes)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        e.SerializeTo(buf, sizeof(buf));
+    }
+    endTimer("Pairing::SerializeTo (" + std::to_string(Pairing::SERIALIZED_SIZE) + " bytes)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Pairing d = Pairing::DeserializeFrom(buf, sizeof(buf));
+    }
+    endTimer("Pairing::DeserializeFrom", start, numIters);
+}
+
+void BenchHashToCurve() {
+    InitMCL();
+
+    auto start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Point p = Point::HashToPoint(callDetails + std::to_string(i));
+    }
+    endTimer("Point::HashToPoint (setHashOf + mapToG1)", start, numIters);
+
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Point p = Point::HashToCurve(callDetails + std::to_string(i));
+    }
+    endTimer("Point::HashToCurve (XMD:SHA-256, two maps)", start, numIters);
+
+    HashedPointCache cache;
+    cache.Get(callDetails);
+    start = startTimer();
+    for (auto i = 0; i < numIters; i++) {
+        Point p = cache.Get(callDetails);
+    }
+    endTimer("HashedPointCache::Get (hit)", start, numIters);
 }
 
 int main(int argc, char* argv[])
@@ -118,15 +521,32 @@ int main(int argc, char* argv[])
     
     // OPRF
     BenchBlinding();
+    BenchBlindingPool();
     BenchEvaluation();
+    BenchEvaluationBatch();
+    BenchVerifiableBatch();
     BenchUnblinding();
+    BenchUnblindingPrepared();
+    BenchFixedWidth();
+    BenchXor();
 
     // Ciphering
     BenchEncryption();
     BenchDecryption();
+    BenchEncryptionInPlace();
+    BenchCipherContext();
+    BenchCipherBatch();
+    BenchStreamEncryption();
 
     // VOPRF
+    std::cout << "VOPRF curve: " << DefaultCurve::NAME << std::endl;
     BenchVOPRF();
+    BenchExecutionModes();
+    BenchVOPRFBatch();
+    BenchVOPRFVerifyBatch();
+    BenchMulVec();
+    BenchSerialization();
+    BenchHashToCurve();
 
     return 0;
 }
\ No newline at end of file
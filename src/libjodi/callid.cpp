@@ -0,0 +1,116 @@
+#include <chrono>
+#include <future>
+#include "libjodi.hpp"
+
+namespace libjodi {
+    typedef std::chrono::steady_clock Clock;
+
+    static long elapsedUs(const Clock::time_point &start) {
+        return (long)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    }
+
+    static OPRF_Element decodeElement(const json &payload, const char *field, const string &server) {
+        if (!payload.contains(field) || !payload[field].is_string()) {
+            panic("GenerateCallId: missing '" + string(field) + "' in reply from " + server);
+        }
+
+        Bytes bytes = Utils::DecodeBase64(payload[field].get<string>());
+        if (bytes.size() != crypto_core_ristretto255_BYTES) {
+            panic("GenerateCallId: invalid '" + string(field) + "' in reply from " + server);
+        }
+
+        OPRF_Element out;
+        std::copy(bytes.begin(), bytes.end(), out.begin());
+        return out;
+    }
+
+    vector<uint8_t> GenerateCallId(string callDetails, vector<string> servers) {
+        CallIdTimings timings;
+        return GenerateCallId(callDetails, servers, timings);
+    }
+
+    /**
+     * Blinds callDetails once, posts x to every server concurrently and
+     * unblinds each reply on its own thread as soon as it lands. The call ID
+     * is SHA-256 over the XOR of all labels, so it does not depend on the
+     * order in which replies arrive.
+     *
+     * Wire format: POST x=<base64> to each server URL; the reply is JSON with
+     * base64 "fx" and "vk" fields.
+     */
+    vector<uint8_t> GenerateCallId(const string& callDetails, const vector<string>& servers, CallIdTimings& timings) {
+        if (servers.empty()) {
+            panic("GenerateCallId: no servers given");
+        }
+
+        auto totalStart = Clock::now();
+        timings = CallIdTimings();
+        timings.serverUs.assign(servers.size(), 0);
+
+        auto start = Clock::now();
+        OPRF_Element x;
+        OPRF_Scalar r;
+        OPRF::Blind(callDetails, x, r);
+        string xb64 = Utils::EncodeBase64(Bytes(x.begin(), x.end()));
+        timings.blindUs = elapsedUs(start);
+
+        start = Clock::now();
+        vector<std::future<OPRF_Element>> replies;
+        replies.reserve(servers.size());
+
+        for (size_t i = 0; i < servers.size(); i++) {
+            replies.emplace_back(std::async(std::launch::async, [&, i]() {
+                auto serverStart = Clock::now();
+
+                Request req;
+                req.endpoint = servers[i];
+                req.body["x"] = xb64;
+
+                Response resp = Http::post(req);
+                if (!resp.success) {
+                    panic("GenerateCallId: " + servers[i] + ": " + resp.errorMessage);
+                }
+
+                OPRF_Element fx = decodeElement(resp.payload, "fx", servers[i]);
+                OPRF_Element vk = decodeElement(resp.payload, "vk", servers[i]);
+
+                OPRF_Element label;
+                OPRF::Unblind(fx, vk, r, label);
+
+                timings.serverUs[i] = elapsedUs(serverStart);
+                return label;
+            }));
+        }
+
+        // Wait for every reply before reporting the first failure, so no
+        // request outlives the buffers it references.
+        vector<OPRF_Element> labels(servers.size());
+        std::exception_ptr error;
+        for (size_t i = 0; i < replies.size(); i++) {
+            try {
+                labels[i] = replies[i].get();
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        sodium_memzero(r.data(), r.size());
+        timings.fanoutUs = elapsedUs(start);
+
+        if (error) std::rethrow_exception(error);
+
+        start = Clock::now();
+        OPRF_Element combined = {};
+        for (const auto &label : labels) {
+            for (size_t b = 0; b < combined.size(); b++) {
+                combined[b] ^= label[b];
+            }
+        }
+
+        Bytes callId(crypto_hash_sha256_BYTES);
+        crypto_hash_sha256(callId.data(), combined.data(), combined.size());
+        timings.combineUs = elapsedUs(start);
+
+        timings.totalUs = elapsedUs(totalStart);
+        return callId;
+    }
+}
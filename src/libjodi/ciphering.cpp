@@ -8,68 +8,455 @@ namespace libjodi {
         return key;
     }
 
-    Bytes Ciphering::Encrypt(const Bytes &key, const Bytes &plaintext) {
-        if (key.size() != crypto_aead_xchacha20poly1305_ietf_KEYBYTES) {
-            panic("Invalid key size.");
+    const char *CipherStatusMessage(CipherStatus status) {
+        switch (status) {
+            case CipherStatus::Ok: return "OK";
+            case CipherStatus::InvalidKey: return "Invalid key size.";
+            case CipherStatus::BufferTooSmall: return "Output buffer too small.";
+            case CipherStatus::InvalidCiphertext: return "Invalid Ciphertext";
+            case CipherStatus::EncryptionFailed: return "Encryption failed.";
+            case CipherStatus::DecryptionFailed: return "Decryption failed. Invalid ciphertext or key.";
+            case CipherStatus::UnsupportedAlgorithm: return "Cipher algorithm not supported on this CPU.";
         }
+        return "Unknown error";
+    }
 
-        Bytes nonce(crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
-        randombytes_buf(nonce.data(), nonce.size());
+    CipherStatus Ciphering::Encrypt(const Bytes &key, const unsigned char *plaintext, size_t len,
+                                    unsigned char *out, size_t outLen, size_t *written) {
+        if (key.size() != crypto_aead_xchacha20poly1305_ietf_KEYBYTES) {
+            return CipherStatus::InvalidKey;
+        }
+        if (outLen < CiphertextSize(len)) {
+            return CipherStatus::BufferTooSmall;
+        }
 
-        Bytes ctx(plaintext.size() + crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        // The nonce goes in front, so the AEAD output lands right where an
+        // in-place plaintext already is
+        randombytes_buf(out, NONCE_SIZE);
 
         unsigned long long ctx_len;
+        if (crypto_aead_xchacha20poly1305_ietf_encrypt(
+                out + NONCE_SIZE, &ctx_len,
+                plaintext, len,
+                NULL, 0,
+                NULL, // no secret nonce
+                out, key.data()) != 0) {
+            return CipherStatus::EncryptionFailed;
+        }
 
-        const unsigned char *ad = NULL;
-        size_t ad_len = 0;
+        if (written) *written = NONCE_SIZE + (size_t)ctx_len;
+        return CipherStatus::Ok;
+    }
 
-        if (crypto_aead_xchacha20poly1305_ietf_encrypt(
-                ctx.data(), &ctx_len,
-                plaintext.data(), plaintext.size(),
-                ad, ad_len,
+    CipherStatus Ciphering::Decrypt(const Bytes &key, const unsigned char *ciphertext, size_t len,
+                                    unsigned char *out, size_t outLen, size_t *written) {
+        if (key.size() != crypto_aead_xchacha20poly1305_ietf_KEYBYTES) {
+            return CipherStatus::InvalidKey;
+        }
+        if (len < OVERHEAD) {
+            return CipherStatus::InvalidCiphertext;
+        }
+        if (outLen < PlaintextSize(len)) {
+            return CipherStatus::BufferTooSmall;
+        }
+
+        unsigned long long plaintext_len;
+        if (crypto_aead_xchacha20poly1305_ietf_decrypt(
+                out, &plaintext_len,
                 NULL, // no secret nonce
-                nonce.data(), key.data()) != 0) {
-            panic("Encryption failed.");
+                ciphertext + NONCE_SIZE, len - NONCE_SIZE,
+                NULL, 0,
+                ciphertext, key.data()) != 0) {
+            return CipherStatus::DecryptionFailed;
         }
 
-        ctx.resize(ctx_len);
-        nonce.insert(nonce.end(), ctx.begin(), ctx.end());
-        return nonce;
+        if (written) *written = (size_t)plaintext_len;
+        return CipherStatus::Ok;
+    }
+
+    Bytes Ciphering::Encrypt(const Bytes &key, const Bytes &plaintext) {
+        Bytes ciphertext(CiphertextSize(plaintext.size()));
+        size_t written;
+        CipherStatus status = Encrypt(key, plaintext.data(), plaintext.size(), ciphertext.data(), ciphertext.size(), &written);
+        if (status != CipherStatus::Ok) {
+            panic(CipherStatusMessage(status));
+        }
+        return ciphertext;
     }
 
     Bytes Ciphering::Decrypt(const Bytes &key, const Bytes &ciphertext) {
+        Bytes plaintext(PlaintextSize(ciphertext.size()));
+        size_t written;
+        CipherStatus status = Decrypt(key, ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), &written);
+        if (status != CipherStatus::Ok) {
+            panic(CipherStatusMessage(status));
+        }
+        plaintext.resize(written);
+        return plaintext;
+    }
+
+    bool CipherBatch::AllOk() const {
+        for (auto st : status) {
+            if (st != CipherStatus::Ok) return false;
+        }
+        return true;
+    }
+
+    // Output sizes are known up front, so the arena is allocated once and
+    // every worker writes its items straight into their slots
+    template <class SizeFn, class CipherFn>
+    static CipherBatch runBatch(const vector<CipherBatchItem> &items, WorkerPool &pool, SizeFn size, CipherFn cipher) {
+        size_t n = items.size();
+        CipherBatch batch;
+        batch.offsets.resize(n + 1);
+        batch.status.resize(n);
+
+        batch.offsets[0] = 0;
+        for (size_t i = 0; i < n; i++) {
+            batch.offsets[i + 1] = batch.offsets[i] + size(items[i].second.size());
+        }
+        batch.arena.resize(batch.offsets[n]);
+
+        pool.ParallelFor(n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                unsigned char *out = batch.arena.data() + batch.offsets[i];
+                size_t len = batch.Length(i);
+                size_t written;
+
+                const Bytes &msg = items[i].second;
+                batch.status[i] = cipher(items[i].first, msg.data(), msg.size(), out, len, &written);
+                if (batch.status[i] == CipherStatus::Ok && written != len) {
+                    batch.status[i] = CipherStatus::InvalidCiphertext;
+                }
+                if (batch.status[i] != CipherStatus::Ok) {
+                    sodium_memzero(out, len);
+                }
+            }
+        }, WorkerPool::DEFAULT_MIN_CHUNK);
+
+        return batch;
+    }
+
+    CipherBatch Ciphering::EncryptBatch(const vector<CipherBatchItem> &items, WorkerPool &pool) {
+        CipherStatus (*encrypt)(const Bytes &, const unsigned char *, size_t, unsigned char *, size_t, size_t *) = Encrypt;
+        return runBatch(items, pool, CiphertextSize, encrypt);
+    }
+
+    CipherBatch Ciphering::DecryptBatch(const vector<CipherBatchItem> &items, WorkerPool &pool) {
+        CipherStatus (*decrypt)(const Bytes &, const unsigned char *, size_t, unsigned char *, size_t, size_t *) = Decrypt;
+        return runBatch(items, pool, PlaintextSize, decrypt);
+    }
+
+    static void putLE32(unsigned char *out, uint32_t v) {
+        for (int b = 0; b < 4; b++) out[b] = (unsigned char)(v >> (8 * b));
+    }
+
+    static uint32_t getLE32(const unsigned char *in) {
+        uint32_t v = 0;
+        for (int b = 0; b < 4; b++) v |= (uint32_t)in[b] << (8 * b);
+        return v;
+    }
+
+    StreamEncryptor::StreamEncryptor(const Bytes &key, size_t chunkSize) : chunkSize(chunkSize) {
+        if (key.size() != crypto_secretstream_xchacha20poly1305_KEYBYTES) {
+            panic("Invalid key size.");
+        }
+        if (chunkSize == 0 || chunkSize > Ciphering::STREAM_MAX_CHUNK_SIZE) {
+            panic("Invalid stream chunk size.");
+        }
+
+        header.resize(HEADER_SIZE);
+        putLE32(header.data(), (uint32_t)chunkSize);
+        crypto_secretstream_xchacha20poly1305_init_push(&state, header.data() + 4, key.data());
+    }
+
+    StreamEncryptor::~StreamEncryptor() {
+        sodium_memzero(&state, sizeof(state));
+    }
+
+    // Every record authenticates the chunk size from the header as
+    // additional data, so a tampered size cannot go unnoticed
+    void StreamEncryptor::Push(const unsigned char *chunk, size_t len, bool final, Bytes &record) {
+        if (finished) {
+            panic("Stream already finished.");
+        }
+        if (len > chunkSize || (!final && len != chunkSize)) {
+            panic("Invalid stream chunk length.");
+        }
+
+        record.resize(len + RECORD_OVERHEAD);
+        unsigned char tag = final ? crypto_secretstream_xchacha20poly1305_TAG_FINAL
+                                  : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+        if (crypto_secretstream_xchacha20poly1305_push(
+                &state, record.data(), NULL,
+                chunk, len,
+                header.data(), 4,
+                tag) != 0) {
+            panic("Encryption failed.");
+        }
+        finished = final;
+    }
+
+    Bytes StreamEncryptor::Push(const Bytes &chunk, bool final) {
+        Bytes record;
+        Push(chunk.data(), chunk.size(), final, record);
+        return record;
+    }
+
+    StreamDecryptor::StreamDecryptor(const Bytes &key, const Bytes &header) {
+        if (key.size() != crypto_secretstream_xchacha20poly1305_KEYBYTES) {
+            panic("Invalid key size.");
+        }
+        if (header.size() != StreamEncryptor::HEADER_SIZE) {
+            panic("Invalid stream header.");
+        }
+
+        chunkSize = getLE32(header.data());
+        if (chunkSize == 0 || chunkSize > Ciphering::STREAM_MAX_CHUNK_SIZE) {
+            panic("Invalid stream header.");
+        }
+
+        std::copy(header.begin(), header.begin() + 4, ad);
+        if (crypto_secretstream_xchacha20poly1305_init_pull(&state, header.data() + 4, key.data()) != 0) {
+            panic("Invalid stream header.");
+        }
+    }
+
+    StreamDecryptor::~StreamDecryptor() {
+        sodium_memzero(&state, sizeof(state));
+    }
+
+    void StreamDecryptor::Pull(const unsigned char *record, size_t len, Bytes &chunk) {
+        if (finished) {
+            panic("Data after the end of the stream.");
+        }
+        if (len < StreamEncryptor::RECORD_OVERHEAD || len > GetRecordSize()) {
+            panic("Invalid stream record.");
+        }
+
+        chunk.resize(len - StreamEncryptor::RECORD_OVERHEAD);
+        unsigned char tag;
+        if (crypto_secretstream_xchacha20poly1305_pull(
+                &state, chunk.data(), NULL, &tag,
+                record, len,
+                ad, sizeof(ad)) != 0) {
+            panic("Decryption failed. Invalid ciphertext or key.");
+        }
+
+        if (tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL) {
+            finished = true;
+        } else if (len != GetRecordSize()) {
+            panic("Invalid stream record.");
+        }
+    }
+
+    Bytes StreamDecryptor::Pull(const Bytes &record) {
+        Bytes chunk;
+        Pull(record.data(), record.size(), chunk);
+        return chunk;
+    }
+
+    // Reads up to len bytes, stopping early only at end of input
+    static size_t readFull(std::istream &in, Bytes &buf, size_t len) {
+        buf.resize(len);
+        in.read(reinterpret_cast<char *>(buf.data()), len);
+        if (in.bad()) {
+            panic("Stream read failed.");
+        }
+        return (size_t)in.gcount();
+    }
+
+    static void writeFull(std::ostream &out, const Bytes &buf) {
+        out.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+        if (!out) {
+            panic("Stream write failed.");
+        }
+    }
+
+    void Ciphering::EncryptStream(const Bytes &key, std::istream &in, std::ostream &out, size_t chunkSize) {
+        StreamEncryptor enc(key, chunkSize);
+        writeFull(out, enc.GetHeader());
+
+        Bytes chunk, record;
+        do {
+            size_t len = readFull(in, chunk, chunkSize);
+            // A full chunk is the last one only if nothing follows it
+            bool final = len < chunkSize || in.peek() == std::char_traits<char>::eof();
+            enc.Push(chunk.data(), len, final, record);
+            writeFull(out, record);
+        } while (!enc.IsFinished());
+
+        sodium_memzero(chunk.data(), chunk.size());
+    }
+
+    void Ciphering::DecryptStream(const Bytes &key, std::istream &in, std::ostream &out) {
+        Bytes header;
+        if (readFull(in, header, StreamEncryptor::HEADER_SIZE) != StreamEncryptor::HEADER_SIZE) {
+            panic("Invalid stream header.");
+        }
+
+        StreamDecryptor dec(key, header);
+        Bytes record, chunk;
+        while (!dec.IsFinished()) {
+            size_t len = readFull(in, record, dec.GetRecordSize());
+            if (len == 0) {
+                panic("Truncated stream.");
+            }
+            dec.Pull(record.data(), len, chunk);
+            writeFull(out, chunk);
+        }
+
+        if (in.peek() != std::char_traits<char>::eof()) {
+            panic("Data after the end of the stream.");
+        }
+        sodium_memzero(chunk.data(), chunk.size());
+    }
+
+    static const char CIPHER_AES_SUBKEY_CONTEXT[] = "JODI-CipherContext-AES256GCM";
+
+    static size_t nonceSize(CipherAlgorithm algorithm) {
+        return algorithm == CipherAlgorithm::Aes256Gcm ? crypto_aead_aes256gcm_NPUBBYTES
+                                                       : crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+    }
+
+    // CPU features are only detected by sodium_init()
+    bool CipherContext::IsAesAvailable() {
+        GlobalInitSodium();
+        return crypto_aead_aes256gcm_is_available() == 1;
+    }
+
+    CipherContext::CipherContext(const Bytes &key) {
+        init(key);
+        algorithm = hasAes ? CipherAlgorithm::Aes256Gcm : CipherAlgorithm::XChaCha20Poly1305;
+    }
+
+    CipherContext::CipherContext(const Bytes &key, CipherAlgorithm algorithm) : algorithm(algorithm) {
+        if (algorithm != CipherAlgorithm::XChaCha20Poly1305 && algorithm != CipherAlgorithm::Aes256Gcm) {
+            panic("Unknown cipher algorithm.");
+        }
+        init(key);
+        if (algorithm == CipherAlgorithm::Aes256Gcm && !hasAes) {
+            panic(CipherStatusMessage(CipherStatus::UnsupportedAlgorithm));
+        }
+    }
+
+    void CipherContext::init(const Bytes &key) {
+        GlobalInitSodium();
         if (key.size() != crypto_aead_xchacha20poly1305_ietf_KEYBYTES) {
             panic("Invalid key size.");
         }
+        std::copy(key.begin(), key.end(), this->key);
+
+        // Keep the two algorithms on separate keys
+        hasAes = IsAesAvailable();
+        if (hasAes) {
+            unsigned char aesKey[crypto_aead_aes256gcm_KEYBYTES];
+            crypto_generichash(aesKey, sizeof(aesKey),
+                               reinterpret_cast<const unsigned char *>(CIPHER_AES_SUBKEY_CONTEXT), sizeof(CIPHER_AES_SUBKEY_CONTEXT) - 1,
+                               this->key, sizeof(this->key));
+            crypto_aead_aes256gcm_beforenm(&aesState, aesKey);
+            sodium_memzero(aesKey, sizeof(aesKey));
+        }
+    }
 
-        if (ciphertext.size() <= crypto_aead_xchacha20poly1305_ietf_NPUBBYTES) {
-            panic("Invalid Ciphertext");
+    CipherContext::~CipherContext() {
+        sodium_memzero(key, sizeof(key));
+        sodium_memzero(&aesState, sizeof(aesState));
+    }
+
+    size_t CipherContext::CiphertextSize(size_t plaintextLen) const {
+        return 1 + nonceSize(algorithm) + plaintextLen + crypto_aead_xchacha20poly1305_ietf_ABYTES;
+    }
+
+    size_t CipherContext::MaxPlaintextSize(size_t ciphertextLen) {
+        size_t minOverhead = 1 + crypto_aead_aes256gcm_NPUBBYTES + crypto_aead_aes256gcm_ABYTES;
+        return ciphertextLen < minOverhead ? 0 : ciphertextLen - minOverhead;
+    }
+
+    CipherStatus CipherContext::Encrypt(const unsigned char *plaintext, size_t len,
+                                        unsigned char *out, size_t outLen, size_t *written) const {
+        if (outLen < CiphertextSize(len)) {
+            return CipherStatus::BufferTooSmall;
         }
 
-        Bytes nonce(ciphertext.begin(), ciphertext.begin() + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
-        Bytes ctx(ciphertext.begin() + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, ciphertext.end());
+        out[0] = (unsigned char)algorithm;
+        unsigned char *nonce = out + 1;
+        unsigned char *body = nonce + nonceSize(algorithm);
+        randombytes_buf(nonce, nonceSize(algorithm));
 
-        if (ctx.empty()) {
-            panic("Null ciphertext");
+        unsigned long long ctx_len;
+        int rc;
+        if (algorithm == CipherAlgorithm::Aes256Gcm) {
+            rc = crypto_aead_aes256gcm_encrypt_afternm(body, &ctx_len, plaintext, len, out, 1, NULL, nonce, &aesState);
+        } else {
+            rc = crypto_aead_xchacha20poly1305_ietf_encrypt(body, &ctx_len, plaintext, len, out, 1, NULL, nonce, key);
+        }
+        if (rc != 0) {
+            return CipherStatus::EncryptionFailed;
         }
 
-        Bytes plaintext(ctx.size() - crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        if (written) *written = (size_t)(body - out) + (size_t)ctx_len;
+        return CipherStatus::Ok;
+    }
 
+    CipherStatus CipherContext::Decrypt(const unsigned char *ciphertext, size_t len,
+                                        unsigned char *out, size_t outLen, size_t *written) const {
+        if (len == 0) {
+            return CipherStatus::InvalidCiphertext;
+        }
+
+        CipherAlgorithm alg = (CipherAlgorithm)ciphertext[0];
+        if (alg != CipherAlgorithm::XChaCha20Poly1305 && alg != CipherAlgorithm::Aes256Gcm) {
+            return CipherStatus::InvalidCiphertext;
+        }
+        if (alg == CipherAlgorithm::Aes256Gcm && !hasAes) {
+            return CipherStatus::UnsupportedAlgorithm;
+        }
+
+        size_t header = 1 + nonceSize(alg);
+        if (len < header + crypto_aead_xchacha20poly1305_ietf_ABYTES) {
+            return CipherStatus::InvalidCiphertext;
+        }
+        if (outLen < len - header - crypto_aead_xchacha20poly1305_ietf_ABYTES) {
+            return CipherStatus::BufferTooSmall;
+        }
+
+        const unsigned char *nonce = ciphertext + 1;
         unsigned long long plaintext_len;
-        const unsigned char *ad = NULL;
-        size_t ad_len = 0;
+        int rc;
+        if (alg == CipherAlgorithm::Aes256Gcm) {
+            rc = crypto_aead_aes256gcm_decrypt_afternm(out, &plaintext_len, NULL, ciphertext + header, len - header,
+                                                       ciphertext, 1, nonce, &aesState);
+        } else {
+            rc = crypto_aead_xchacha20poly1305_ietf_decrypt(out, &plaintext_len, NULL, ciphertext + header, len - header,
+                                                            ciphertext, 1, nonce, key);
+        }
+        if (rc != 0) {
+            return CipherStatus::DecryptionFailed;
+        }
 
-        if (crypto_aead_xchacha20poly1305_ietf_decrypt(
-                plaintext.data(), &plaintext_len,
-                NULL, // no secret nonce
-                ctx.data(), ctx.size(),
-                ad, ad_len,
-                nonce.data(), key.data()) != 0) {
-            panic("Decryption failed. Invalid ciphertext or key.");
+        if (written) *written = (size_t)plaintext_len;
+        return CipherStatus::Ok;
+    }
+
+    Bytes CipherContext::Encrypt(const Bytes &plaintext) const {
+        Bytes ciphertext(CiphertextSize(plaintext.size()));
+        size_t written;
+        CipherStatus status = Encrypt(plaintext.data(), plaintext.size(), ciphertext.data(), ciphertext.size(), &written);
+        if (status != CipherStatus::Ok) {
+            panic(CipherStatusMessage(status));
         }
+        return ciphertext;
+    }
 
-        plaintext.resize(plaintext_len);
-        
+    Bytes CipherContext::Decrypt(const Bytes &ciphertext) const {
+        Bytes plaintext(MaxPlaintextSize(ciphertext.size()));
+        size_t written;
+        CipherStatus status = Decrypt(ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), &written);
+        if (status != CipherStatus::Ok) {
+            panic(CipherStatusMessage(status));
+        }
+        plaintext.resize(written);
         return plaintext;
     }
-}
\ No newline at end of file
+}
@@ -161,9 +161,11 @@ namespace libjodi {
 
         curl_slist *chunk = setRequestHeaders(curl, req.headers);
 
+        // CURLOPT_POSTFIELDS does not copy, so the body must outlive the transfer
+        std::string postFields;
         if (isPost) {
             curl_easy_setopt(curl, CURLOPT_POST, 1L);
-            std::string postFields = buildPostFields(curl, req.body);
+            postFields = buildPostFields(curl, req.body);
             curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postFields.c_str());
         }
 
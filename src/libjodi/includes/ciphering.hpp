@@ -2,14 +2,192 @@
 #define CIPHERING_HPP
 
 #include "base.hpp"
+#include "workers.hpp"
+#include <sodium.h>
 
 namespace libjodi {
+    // Outcome of the buffer-based Ciphering calls, which never throw
+    enum class CipherStatus {
+        Ok = 0,
+        InvalidKey,
+        BufferTooSmall,
+        InvalidCiphertext,
+        EncryptionFailed,
+        DecryptionFailed,
+        UnsupportedAlgorithm
+    };
+
+    const char *CipherStatusMessage(CipherStatus status);
+
+    /**
+     * Outputs of one EncryptBatch/DecryptBatch call, packed into a single
+     * arena. Item i spans arena[offsets[i], offsets[i + 1]) and succeeded
+     * iff status[i] is Ok; the span of a failed item is zeroed.
+     */
+    struct CipherBatch {
+        Bytes arena;
+        vector<size_t> offsets;
+        vector<CipherStatus> status;
+
+        size_t Size() const { return status.size(); }
+        const unsigned char *Data(size_t i) const { return arena.data() + offsets[i]; }
+        size_t Length(size_t i) const { return offsets[i + 1] - offsets[i]; }
+        Bytes Get(size_t i) const { return Bytes(Data(i), Data(i) + Length(i)); }
+        bool AllOk() const;
+    };
+
+    // (key, message) pairs for the batch calls
+    typedef std::pair<Bytes, Bytes> CipherBatchItem;
+
     class Ciphering {
         public:
+            // Ciphertext layout: nonce | AEAD ciphertext | tag
+            static const size_t NONCE_SIZE = crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+            static const size_t OVERHEAD = NONCE_SIZE + crypto_aead_xchacha20poly1305_ietf_ABYTES;
+
+            // Plaintext bytes per stream record, and the largest chunk size a
+            // decryptor accepts from a stream header
+            static const size_t STREAM_CHUNK_SIZE = 64 * 1024;
+            static const size_t STREAM_MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+
             Ciphering();
             static Bytes Keygen();
             static Bytes Encrypt(const Bytes &key, const Bytes &plaintext);
             static Bytes Decrypt(const Bytes &key, const Bytes &ciphertext);
+
+            static size_t CiphertextSize(size_t plaintextLen) { return plaintextLen + OVERHEAD; }
+            // 0 for inputs too short to be a ciphertext
+            static size_t PlaintextSize(size_t ciphertextLen) { return ciphertextLen < OVERHEAD ? 0 : ciphertextLen - OVERHEAD; }
+
+            // Into caller buffers, without intermediate copies. written receives
+            // the output length. To work in place, encrypt with
+            // plaintext == out + NONCE_SIZE and decrypt with
+            // out == ciphertext + NONCE_SIZE; other overlaps are not allowed.
+            static CipherStatus Encrypt(const Bytes &key, const unsigned char *plaintext, size_t len,
+                                        unsigned char *out, size_t outLen, size_t *written);
+            static CipherStatus Decrypt(const Bytes &key, const unsigned char *ciphertext, size_t len,
+                                        unsigned char *out, size_t outLen, size_t *written);
+
+            // Independent items spread over the pool; a bad item only fails
+            // its own entry
+            static CipherBatch EncryptBatch(const vector<CipherBatchItem> &items, WorkerPool &pool = WorkerPool::GetDefault());
+            static CipherBatch DecryptBatch(const vector<CipherBatchItem> &items, WorkerPool &pool = WorkerPool::GetDefault());
+
+            // Stream in to out chunk by chunk; memory use is one chunk whatever
+            // the payload size. DecryptStream may already have written some
+            // plaintext when it fails, and that output must be discarded.
+            static void EncryptStream(const Bytes &key, std::istream &in, std::ostream &out, size_t chunkSize = STREAM_CHUNK_SIZE);
+            static void DecryptStream(const Bytes &key, std::istream &in, std::ostream &out);
+    };
+
+    /**
+     * Push side of a chunked stream built on libsodium's secretstream
+     * (XChaCha20-Poly1305). The stream is GetHeader() followed by one record
+     * per chunk, each RECORD_OVERHEAD bytes longer than its plaintext. Every
+     * chunk but the last must be exactly the chunk size; the last one is
+     * tagged final so a truncated stream fails to decrypt.
+     */
+    class StreamEncryptor {
+        public:
+            // Chunk size (LE32) followed by the secretstream header
+            static const size_t HEADER_SIZE = 4 + crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+            static const size_t RECORD_OVERHEAD = crypto_secretstream_xchacha20poly1305_ABYTES;
+
+            explicit StreamEncryptor(const Bytes &key, size_t chunkSize = Ciphering::STREAM_CHUNK_SIZE);
+            ~StreamEncryptor();
+
+            StreamEncryptor(StreamEncryptor const&) = delete;
+            StreamEncryptor& operator=(StreamEncryptor const&) = delete;
+
+            const Bytes &GetHeader() const { return header; }
+            size_t GetChunkSize() const { return chunkSize; }
+            bool IsFinished() const { return finished; }
+
+            // Encrypts one chunk into record, which is resized to fit and can
+            // be reused across calls
+            void Push(const unsigned char *chunk, size_t len, bool final, Bytes &record);
+            Bytes Push(const Bytes &chunk, bool final = false);
+
+        private:
+            crypto_secretstream_xchacha20poly1305_state state;
+            Bytes header;
+            size_t chunkSize;
+            bool finished = false;
+    };
+
+    // Pull side of StreamEncryptor; records must be fed in order
+    class StreamDecryptor {
+        public:
+            StreamDecryptor(const Bytes &key, const Bytes &header);
+            ~StreamDecryptor();
+
+            StreamDecryptor(StreamDecryptor const&) = delete;
+            StreamDecryptor& operator=(StreamDecryptor const&) = delete;
+
+            size_t GetChunkSize() const { return chunkSize; }
+            size_t GetRecordSize() const { return chunkSize + StreamEncryptor::RECORD_OVERHEAD; }
+            // True once the final record has been authenticated
+            bool IsFinished() const { return finished; }
+
+            void Pull(const unsigned char *record, size_t len, Bytes &chunk);
+            Bytes Pull(const Bytes &record);
+
+        private:
+            crypto_secretstream_xchacha20poly1305_state state;
+            unsigned char ad[4];
+            size_t chunkSize;
+            bool finished = false;
+    };
+
+    // First byte of every CipherContext ciphertext
+    enum class CipherAlgorithm : uint8_t {
+        XChaCha20Poly1305 = 1,
+        Aes256Gcm = 2
+    };
+
+    /**
+     * A key validated once and prepared for many messages. AES-256-GCM with
+     * a precomputed key schedule is used when the CPU has hardware AES,
+     * XChaCha20-Poly1305 otherwise. Ciphertexts are
+     * algorithm (1 byte) | nonce | ciphertext | tag, with the algorithm byte
+     * authenticated, so any context decrypts either kind as long as this
+     * CPU supports it. AES-GCM runs on a subkey derived from the key, and
+     * its 96-bit random nonces keep a key safe for about 2^32 messages.
+     */
+    class CipherContext {
+        public:
+            static const size_t MAX_OVERHEAD = 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES;
+
+            explicit CipherContext(const Bytes &key);
+            // Throws if algorithm is AES-256-GCM and the CPU lacks AES support
+            CipherContext(const Bytes &key, CipherAlgorithm algorithm);
+            ~CipherContext();
+
+            CipherContext(CipherContext const&) = delete;
+            CipherContext& operator=(CipherContext const&) = delete;
+
+            static bool IsAesAvailable();
+
+            CipherAlgorithm GetAlgorithm() const { return algorithm; }
+            size_t CiphertextSize(size_t plaintextLen) const;
+            // Upper bound on the plaintext of a ciphertext of this length
+            static size_t MaxPlaintextSize(size_t ciphertextLen);
+
+            CipherStatus Encrypt(const unsigned char *plaintext, size_t len,
+                                 unsigned char *out, size_t outLen, size_t *written) const;
+            CipherStatus Decrypt(const unsigned char *ciphertext, size_t len,
+                                 unsigned char *out, size_t outLen, size_t *written) const;
+
+            Bytes Encrypt(const Bytes &plaintext) const;
+            Bytes Decrypt(const Bytes &ciphertext) const;
+
+        private:
+            CipherAlgorithm algorithm;
+            bool hasAes = false;
+            unsigned char key[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+            crypto_aead_aes256gcm_state aesState;
+
+            void init(const Bytes &key);
     };
 }
 
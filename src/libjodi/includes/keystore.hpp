@@ -0,0 +1,33 @@
+#ifndef JODI_KEYSTORE_HPP
+#define JODI_KEYSTORE_HPP
+
+#include "base.hpp"
+#include "oprf.hpp"
+
+namespace libjodi {
+    /**
+     * On-disk copy of a KeyRotation ring so a restarted server keeps serving
+     * the same keys. The file is a fixed little-endian layout followed by a
+     * BLAKE2b-256 checksum; it is read through mmap and replaced atomically
+     * (temp file, fsync, rename) on every save. It holds secret keys and is
+     * created with mode 0600.
+     */
+    class KeyStore {
+        public:
+            static const uint32_t VERSION = 1;
+
+            explicit KeyStore(const std::string& path);
+
+            // Ring stored at path, or nullptr if the file is missing,
+            // truncated, from another version or fails its checksum
+            KeyRingSnapshot Load() const;
+            void Save(const KeyRing& ring) const;
+
+            const std::string& GetPath() const { return path; }
+
+        private:
+            std::string path;
+    };
+}
+
+#endif // JODI_KEYSTORE_HPP
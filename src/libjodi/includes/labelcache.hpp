@@ -0,0 +1,93 @@
+#ifndef JODI_LABELCACHE_HPP
+#define JODI_LABELCACHE_HPP
+
+#include "base.hpp"
+#include "oprf.hpp"
+#include <list>
+#include <unordered_map>
+
+namespace libjodi {
+    struct LabelCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;          // includes lookups that found an invalidated entry
+        uint64_t invalidations = 0;   // entries dropped because their key rotated out
+        uint64_t evictions = 0;       // entries dropped to stay within capacity
+        size_t size = 0;
+    };
+
+    /**
+     * Bounded cache of unblinded OPRF labels, so retries, forked calls and
+     * re-INVITEs for the same call details skip the evaluator round trip.
+     *
+     * Entries are keyed by a keyed BLAKE2b digest of the call details and the
+     * server key index, and remember the server public key they were computed
+     * under; that key pins the epoch of the slot, even across restarts that
+     * reset the epoch counter. A lookup only hits while that key is still in
+     * its slot, or was just rotated out and IsExpiredWithin(index, tmax) still
+     * accepts it. The cache is split into independently locked LRU shards.
+     */
+    class LabelCache {
+        public:
+            explicit LabelCache(std::shared_ptr<KeyRotation> rotation = KeyRotation::GetInstance(),
+                                size_t capacity = 4096, size_t numShards = 16, int tmax = 0);
+
+            LabelCache(LabelCache const&) = delete;
+            LabelCache& operator=(LabelCache const&) = delete;
+
+            bool Get(const string& callDetails, int keyIndex, Bytes& label);
+            // vk is the server key the label was evaluated under, as returned
+            // with the evaluation. Labels whose key is no longer live in the
+            // slot (or inside the tmax grace window) are not stored.
+            void Put(const string& callDetails, int keyIndex, const Bytes& vk, const Bytes& label);
+            void Clear();
+
+            LabelCacheStats GetStats() const;
+            size_t GetCapacity() const { return capacity; }
+
+        private:
+            typedef std::array<unsigned char, crypto_generichash_BYTES> Digest;
+
+            struct Key {
+                Digest digest;
+                int keyIndex;
+                bool operator==(const Key& other) const {
+                    return keyIndex == other.keyIndex && digest == other.digest;
+                }
+            };
+
+            struct KeyHash {
+                size_t operator()(const Key& key) const;
+            };
+
+            struct Entry {
+                Key key;
+                Bytes vk;
+                Bytes label;
+            };
+
+            struct Shard {
+                std::mutex mutex;
+                std::list<Entry> lru;   // most recently used first
+                std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+            };
+
+            std::shared_ptr<KeyRotation> rotation;
+            size_t capacity;
+            size_t shardCapacity;
+            int tmax;
+            unsigned char hashKey[crypto_generichash_KEYBYTES];
+            std::unique_ptr<Shard[]> shards;
+            size_t numShards;
+
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> invalidations{0};
+            std::atomic<uint64_t> evictions{0};
+
+            Key MakeKey(const string& callDetails, int keyIndex) const;
+            Shard& ShardFor(const Key& key) const;
+            bool IsValid(int keyIndex, const Bytes& vk, const KeyRing& ring) const;
+    };
+}
+
+#endif // JODI_LABELCACHE_HPP
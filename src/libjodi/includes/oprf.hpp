@@ -2,12 +2,17 @@
 #define OPRF_HPP
 
 #include <sodium.h>
+#include <array>
 #include <memory>
 #include <random>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 
 #include "base.hpp"
+#include "workers.hpp"
 
 namespace libjodi {
     static void GlobalInitSodium()
@@ -21,12 +26,16 @@ namespace libjodi {
         }
     }
 
+    // Fixed-width ristretto255 values for the allocation-free API
+    typedef std::array<unsigned char, crypto_core_ristretto255_BYTES> OPRF_Element;
+    typedef std::array<unsigned char, crypto_core_ristretto255_SCALARBYTES> OPRF_Scalar;
+
     class OPRF_Keypair {
         public:
             Bytes sk;
             Bytes pk;
             OPRF_Keypair() {};
-            OPRF_Keypair(Bytes sk, Bytes pk): sk(sk), pk(pk) {};
+            OPRF_Keypair(Bytes sk, Bytes pk): sk(std::move(sk)), pk(std::move(pk)) {};
     };
 
     class OPRF_Blinded {
@@ -34,7 +43,7 @@ namespace libjodi {
             Bytes x;
             Bytes r;
             OPRF_Blinded() {};
-            OPRF_Blinded(Bytes x, Bytes r): r(r), x(x) {};
+            OPRF_Blinded(Bytes x, Bytes r): x(std::move(x)), r(std::move(r)) {};
     };
 
     class OPRF_BlindedEval {
@@ -42,21 +51,187 @@ namespace libjodi {
             Bytes fx;
             Bytes vk;
             OPRF_BlindedEval() {};
-            OPRF_BlindedEval(Bytes fx, Bytes vk): fx(fx), vk(vk) {};
+            OPRF_BlindedEval(Bytes fx, Bytes vk): fx(std::move(fx)), vk(std::move(vk)) {};
+    };
+
+    /**
+     * A server public key validated once, for clients that unblind many
+     * evaluations against the same few rotation keys.
+     */
+    class PreparedOprfPublicKey {
+        public:
+            PreparedOprfPublicKey() {};
+            explicit PreparedOprfPublicKey(const Bytes& vk);
+
+            const OPRF_Element& GetElement() const { return vk; }
+            const unsigned char* Data() const { return vk.data(); }
+            Bytes ToBytes() const { return Bytes(vk.begin(), vk.end()); }
+            bool Matches(const Bytes& other) const;
+
+        private:
+            OPRF_Element vk = {};
+            bool valid = false;
+    };
+
+    class OPRF_BatchEval {
+        public:
+            // Evaluations packed back to back, element i at i * crypto_core_ristretto255_BYTES
+            Bytes fx;
+            Bytes vk;
+            OPRF_BatchEval() {};
+
+            size_t Size() const { return fx.size() / crypto_core_ristretto255_BYTES; }
+
+            Bytes Get(size_t i) const {
+                auto begin = fx.begin() + i * crypto_core_ristretto255_BYTES;
+                return Bytes(begin, begin + crypto_core_ristretto255_BYTES);
+            }
+    };
+
+    /**
+     * Chaum-Pedersen/DLEQ proof that every fx in a batch was computed with the
+     * secret behind vk. The batch is folded into one pair of composite points
+     * with hash-derived coefficients, so one proof covers any batch size.
+     */
+    class OPRF_Proof {
+        public:
+            static const size_t SIZE = 2 * crypto_core_ristretto255_SCALARBYTES;
+
+            OPRF_Scalar c = {};
+            OPRF_Scalar s = {};
+            OPRF_Proof() {};
+
+            Bytes ToBytes() const;
+            static OPRF_Proof FromBytes(const Bytes& bytes);
+    };
+
+    struct OPRF_BlindingPoolStats {
+        uint64_t produced = 0;   // pairs computed by the background thread
+        uint64_t consumed = 0;   // pairs handed out to Blind
+        uint64_t misses = 0;     // Blind calls that found the pool empty
+        uint64_t refills = 0;    // times the low watermark woke the producer
+        size_t available = 0;    // pairs ready right now
+    };
+
+    /**
+     * Opt-in pool of precomputed blinding pairs (r, g^r). A background thread
+     * keeps a bounded lock-free queue topped up: it sleeps until the queue
+     * drains to lowWatermark and then refills it to highWatermark.
+     */
+    class OPRF_BlindingPool {
+        public:
+            // highWatermark == 0 means fill to capacity
+            explicit OPRF_BlindingPool(size_t capacity = 1024, size_t lowWatermark = 256, size_t highWatermark = 0);
+            ~OPRF_BlindingPool();
+
+            OPRF_BlindingPool(OPRF_BlindingPool const&) = delete;
+            OPRF_BlindingPool& operator=(OPRF_BlindingPool const&) = delete;
+
+            void Start();
+            void Stop();
+
+            // Pops a ready pair, computing one inline if the pool is empty
+            void Take(OPRF_Scalar& r, OPRF_Element& rG);
+            bool TryTake(OPRF_Scalar& r, OPRF_Element& rG);
+
+            OPRF_BlindingPoolStats GetStats() const;
+            size_t GetCapacity() const { return capacity; }
+            size_t GetLowWatermark() const { return lowWatermark; }
+            size_t GetHighWatermark() const { return highWatermark; }
+
+        private:
+            struct Slot {
+                std::atomic<size_t> seq;
+                OPRF_Scalar r;
+                OPRF_Element rG;
+            };
+
+            size_t capacity;
+            size_t lowWatermark;
+            size_t highWatermark;
+            std::unique_ptr<Slot[]> slots;
+
+            std::atomic<size_t> head{0};
+            std::atomic<size_t> tail{0};
+
+            std::atomic<uint64_t> produced{0};
+            std::atomic<uint64_t> consumed{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> refills{0};
+
+            std::thread producer;
+            std::atomic<bool> running{false};
+            std::atomic<bool> refillRequested{false};
+            std::mutex wakeMutex;
+            std::condition_variable wakeCv;
+
+            size_t Available() const;
+            bool TryPush(const OPRF_Scalar& r, const OPRF_Element& rG);
     };
 
     class OPRF {
         public:
             static OPRF_Keypair Keygen();
+            // Deterministic key: BLAKE2b keyed by masterSeed over (generation, index)
+            static OPRF_Keypair DeriveKeypair(const Bytes& masterSeed, uint64_t generation, uint32_t index);
             static OPRF_Blinded Blind(const std::string &msg);
+            static OPRF_Blinded Blind(const std::string &msg, OPRF_BlindingPool& pool);
             static OPRF_BlindedEval Evaluate(const OPRF_Keypair& keypair, const Bytes& x);
-            static Bytes Unblind(OPRF_BlindedEval eval, OPRF_Blinded& blinding);
-            static Bytes Unblind(OPRF_BlindedEval eval, Bytes& r);
+            static OPRF_BatchEval EvaluateBatch(const OPRF_Keypair& keypair, const vector<Bytes>& xs, WorkerPool& pool = WorkerPool::GetDefault());
+            static OPRF_BatchEval EvaluateBatch(const OPRF_Keypair& keypair, const unsigned char* xs, size_t count, WorkerPool& pool = WorkerPool::GetDefault());
+            static OPRF_BatchEval EvaluateBatch(const OPRF_Keypair& keypair, const vector<Bytes>& xs, OPRF_Proof& proof, WorkerPool& pool = WorkerPool::GetDefault());
+
+            // Verifiable mode: one proof for a whole batch of evaluations
+            static OPRF_Proof ProveBatch(const OPRF_Keypair& keypair, const vector<Bytes>& xs, const OPRF_BatchEval& eval, WorkerPool& pool = WorkerPool::GetDefault());
+            static bool VerifyBatch(const Bytes& vk, const vector<Bytes>& xs, const OPRF_BatchEval& eval, const OPRF_Proof& proof, WorkerPool& pool = WorkerPool::GetDefault());
+
+            static Bytes Unblind(const OPRF_BlindedEval& eval, const OPRF_Blinded& blinding);
+            static Bytes Unblind(const OPRF_BlindedEval& eval, const Bytes& r);
+            static Bytes Unblind(const OPRF_BlindedEval& eval, const PreparedOprfPublicKey& vk, const Bytes& r);
+
+            // Fixed-width variants: no heap allocation, results go to out-parameters
+            static void Keygen(OPRF_Scalar& sk, OPRF_Element& pk);
+            static void DeriveKeypair(const Bytes& masterSeed, uint64_t generation, uint32_t index, OPRF_Scalar& sk, OPRF_Element& pk);
+            static void Blind(const std::string &msg, OPRF_Element& x, OPRF_Scalar& r);
+            static void Blind(const std::string &msg, OPRF_BlindingPool& pool, OPRF_Element& x, OPRF_Scalar& r);
+            static void Evaluate(const OPRF_Scalar& sk, const OPRF_Element& x, OPRF_Element& fx);
+            static void Unblind(const OPRF_Element& fx, const OPRF_Element& vk, const OPRF_Scalar& r, OPRF_Element& out);
+            static void Unblind(const OPRF_Element& fx, const PreparedOprfPublicKey& vk, const OPRF_Scalar& r, OPRF_Element& out);
         
         private:
             OPRF() {};
     };
 
+    /**
+     * Immutable state of the key ring at one epoch. The rotation thread never
+     * modifies a published ring; it builds the next one and swaps it in.
+     */
+    struct KeyRing {
+        uint64_t epoch = 0;     // rotation ticks applied (since genesis in seeded mode)
+        int expiryIndex = -1;
+        int recentlyExpiredIndex = -1;
+        OPRF_Keypair recentlyExpiredKey;
+        std::chrono::time_point<std::chrono::system_clock> recentlyExpiredTime;
+        // When the ring was generated or last rotated; the next tick is due one interval later
+        std::chrono::time_point<std::chrono::system_clock> rotationTime;
+        vector<OPRF_Keypair> keys;
+
+        KeyRing() = default;
+        KeyRing(const KeyRing&) = default;
+        KeyRing(KeyRing&&) = default;
+        KeyRing& operator=(const KeyRing&) = default;
+        KeyRing& operator=(KeyRing&&) = default;
+        // Wipes the secret keys, so a retired ring leaves nothing behind
+        ~KeyRing();
+
+        bool IsExpiredWithin(int index, int tmax) const;
+        const OPRF_Keypair& GetKey(int index) const;
+    };
+
+    typedef std::shared_ptr<const KeyRing> KeyRingSnapshot;
+
+    class KeyStore;
+
     class KeyRotation {
         public:
             ~KeyRotation();
@@ -69,27 +244,57 @@ namespace libjodi {
             }
 
             bool IsExpiredWithin(int index, int tmax);
+            // Persist the ring to path so StartRotation(size, interval) resumes
+            // it after a restart; an empty path disables the store. Takes
+            // effect on the next StartRotation.
+            void UseKeyStore(const std::string& path);
             void StartRotation(int size, int interval);
+            // Seeded mode: every key is derived from masterSeed and the number
+            // of intervals since genesis (unix seconds), so replicas sharing
+            // the seed agree on the ring without coordinating.
+            void StartRotation(int size, int interval, const Bytes& masterSeed, int64_t genesis = 0);
             void StopRotation();
 
-            int GetExpiryIndex() { return expiryIndex; }
-            int GetRecentlyExpiredIndex() { return recentlyExpiredIndex; }
-            OPRF_Keypair GetRecentlyExpiredKey() { return recentlyExpiredKey; }
+            // Seeded-mode ring as of a given tick, derived in parallel
+            static KeyRingSnapshot DeriveRing(const Bytes& masterSeed, int size, int interval, int64_t genesis, uint64_t tick);
+            // Key in slot index as of a given tick, in O(1)
+            static OPRF_Keypair DeriveKey(const Bytes& masterSeed, int size, uint64_t tick, int index);
+            static uint64_t CurrentTick(int interval, int64_t genesis);
+
+            // Consistent view of the whole ring. Wait-free unless the ring
+            // changed since this thread last looked.
+            KeyRingSnapshot GetSnapshot() const;
+
+            int GetExpiryIndex() { return GetSnapshot()->expiryIndex; }
+            int GetRecentlyExpiredIndex() { return GetSnapshot()->recentlyExpiredIndex; }
+            OPRF_Keypair GetRecentlyExpiredKey() { return GetSnapshot()->recentlyExpiredKey; }
+            uint64_t GetEpoch() { return GetSnapshot()->epoch; }
 
             OPRF_Keypair GetKey(int index);
-            int GetListSize() { return keyList.size(); }
+            int GetListSize() { return GetSnapshot()->keys.size(); }
         private:
-            int expiryIndex = -1;
-            bool rotationRunning = false;
-            bool stopRotation = false;
-
-            int recentlyExpiredIndex = -1;
-            OPRF_Keypair recentlyExpiredKey;
-            std::chrono::time_point<std::chrono::system_clock> recentlyExpiredTime;
+            std::atomic<bool> rotationRunning{false};
+            std::atomic<bool> stopRotation{false};
+            std::thread rotationThread;
+            // Wakes the rotation thread early on StopRotation
+            std::mutex wakeMutex;
+            std::condition_variable wakeCv;
+            // Serializes StartRotation/StopRotation/UseKeyStore
+            std::mutex controlMutex;
+            std::shared_ptr<KeyStore> store;
 
-            vector<OPRF_Keypair> keyList;
+            // Published ring; only read through GetSnapshot()
+            std::shared_ptr<const KeyRing> ring = std::make_shared<KeyRing>();
+            // Bumped after every publish so readers can keep a cached copy
+            std::atomic<uint64_t> ringVersion{0};
+            // Serializes writers (start, stop, rotation ticks)
             std::mutex sharedMutex;
 
+            void Publish(std::shared_ptr<const KeyRing> next);
+            void Persist(const KeyRing& next);
+            // Sleeps until deadline; false if StopRotation interrupted it
+            bool WaitUntil(std::chrono::system_clock::time_point deadline);
+
             // Disable constructor to force singleton
             KeyRotation() {};
     };
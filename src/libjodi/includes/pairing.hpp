@@ -3,24 +3,178 @@
 
 #include "base.hpp"
 #include "utils.hpp"
+#include "workers.hpp"
+// mcl fixes its largest field at compile time through the header it is
+// included with, so a build serves one curve family
+#ifdef JODI_CURVE_BLS12_381
+#include <mcl/bls12_381.hpp>
+#else
 #include <mcl/bn256.hpp>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 
 namespace libjodi {
+    /**
+     * Curve policies for the pairing types. Sizes are those of the
+     * compressed encodings mcl produces, so buffers can be sized exactly.
+     * mcl's G1, G2 and Fr are fixed by the header included above, so only
+     * DefaultCurve can be instantiated; JODI_CURVE_BLS12_381 switches it.
+     */
+    struct CurveBN254 {
+        static constexpr const char* NAME = "BN254";
+        static constexpr size_t FR_SIZE = 32;
+        static constexpr size_t FP_SIZE = 32;
+        static constexpr size_t G1_SIZE = 32;
+        static constexpr size_t G2_SIZE = 64;
+        // ceil((log2(p) + 128) / 8) uniform bytes per field element
+        static constexpr size_t HASH_TO_FIELD_LEN = 48;
+        static constexpr const char* HASH_TO_CURVE_DST = "JODI-V01-HashToCurve-BN254G1-SHA256-mclmap";
+
+        static const mcl::CurveParam& Param() { return mcl::BN254; }
+    };
+
+    struct CurveBLS12_381 {
+        static constexpr const char* NAME = "BLS12-381";
+        static constexpr size_t FR_SIZE = 32;
+        static constexpr size_t FP_SIZE = 48;
+        static constexpr size_t G1_SIZE = 48;
+        static constexpr size_t G2_SIZE = 96;
+        static constexpr size_t HASH_TO_FIELD_LEN = 64;
+        static constexpr const char* HASH_TO_CURVE_DST = "JODI-V01-HashToCurve-BLS12381G1-SHA256-mclmap";
+
+        static const mcl::CurveParam& Param() { return mcl::BLS12_381; }
+    };
+
+#ifdef JODI_CURVE_BLS12_381
+    typedef CurveBLS12_381 DefaultCurve;
+#else
+    typedef CurveBN254 DefaultCurve;
+#endif
+
+    // Base of every curve template; instantiating it for a curve other than
+    // the build's is a compile error
+    template <class Curve>
+    struct CurveGuard {
+        static_assert(std::is_same<Curve, DefaultCurve>::value,
+                      "curve does not match this build (see JODI_CURVE_BLS12_381)");
+    };
+
+    // mcl keeps one set of curve parameters per process
+    template <class Curve>
+    static void InitPairing()
+    {
+        (void)CurveGuard<Curve>();
+        mcl::bn::initPairing(Curve::Param());
+    }
+
     static void InitMCL()
     {
-        mcl::bn::initPairing();
+        InitPairing<DefaultCurve>();
+    }
+
+    /**
+     * Whether a scalar multiplication touches secrets. SecretInputs (keys,
+     * blinding factors) uses mcl's constant-time mulCT. PublicInputs is for
+     * verification, where message, key and output are all public, and uses
+     * the faster variable-time mul.
+     */
+    enum class ExecutionMode { SecretInputs, PublicInputs };
+
+    template <class G>
+    static void scalarMul(G& out, const G& p, const mcl::bn::Fr& k, ExecutionMode mode)
+    {
+        if (mode == ExecutionMode::PublicInputs) {
+            G::mul(out, p, k);
+        } else {
+            G::mulCT(out, p, k);
+        }
     }
 
-    class PublicKey {
-        static const int MAX_PK_SIZE = 128;
+    // Below this many terms one mcl mulVec call beats splitting the work
+    static const size_t MULVEC_PARALLEL_MIN = 1024;
+
+    /**
+     * out = sum scalars[i] * points[i] using mcl's bucket (Pippenger) method.
+     * Large inputs are cut into one slice per worker and the partial sums
+     * added. mcl may normalize points in place. Variable-time: public
+     * inputs only.
+     */
+    template <class G>
+    static void mulVecSplit(G& out, G* points, const mcl::bn::Fr* scalars, size_t n, WorkerPool& pool)
+    {
+        out.clear();
+        if (n == 0) return;
+
+        if (n < MULVEC_PARALLEL_MIN || pool.GetSize() == 0) {
+            G::mulVec(out, points, scalars, n);
+            return;
+        }
+
+        std::mutex mutex;
+        pool.ParallelFor(n, [&](size_t begin, size_t end) {
+            G partial;
+            G::mulVec(partial, points + begin, scalars + begin, end - begin);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            G::add(out, out, partial);
+        }, MULVEC_PARALLEL_MIN / 2);
+    }
+
+    // Fixed-size binary encodings straight into caller buffers; used by the
+    // SerializeTo/DeserializeFrom methods below
+    template <class T>
+    static size_t serializeFixed(const T& v, uint8_t* buf, size_t len, size_t size, const char* what)
+    {
+        if (len < size) {
+            throw std::invalid_argument(string(what) + ": buffer too small");
+        }
+        if (v.serialize(buf, size) != size) {
+            throw std::runtime_error(string(what) + ": serialization failed");
+        }
+        return size;
+    }
+
+    template <class T>
+    static void deserializeFixed(T& v, const uint8_t* buf, size_t len, size_t size, const char* what)
+    {
+        if (len < size || v.deserialize(buf, size) != size) {
+            throw std::invalid_argument(string(what) + ": invalid encoding");
+        }
+    }
+
+    template <class Curve> class PrivateKeyT;
+
+    template <class Curve>
+    class PublicKeyT : private CurveGuard<Curve> {
+        typedef PublicKeyT<Curve> PublicKey;
+        typedef PrivateKeyT<Curve> PrivateKey;
 
         public:
+            // Compressed G2 point
+            static constexpr size_t SERIALIZED_SIZE = Curve::G2_SIZE;
+
+            size_t SerializeTo(uint8_t* buf, size_t len) const {
+                return serializeFixed(v, buf, len, SERIALIZED_SIZE, "PublicKey::SerializeTo");
+            }
+
+            static PublicKey DeserializeFrom(const uint8_t* buf, size_t len) {
+                PublicKey pk;
+                deserializeFixed(pk.v, buf, len, SERIALIZED_SIZE, "PublicKey::DeserializeFrom");
+                return pk;
+            }
+
             mcl::bn::G2 GetG2() const {
                 return v;
             }
 
             Bytes ToBytes() const {
-                uint8_t buf[MAX_PK_SIZE];
+                uint8_t buf[SERIALIZED_SIZE];
                 size_t len = v.serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
@@ -40,14 +194,17 @@ namespace libjodi {
                 return FromBytes(bytes);
             }
 
+            // sum ks[i] * pks[i]; variable-time, for public scalars
+            static PublicKey MulVec(const vector<PublicKey>& pks, const vector<PrivateKey>& ks, WorkerPool& pool = WorkerPool::GetDefault());
+
             static mcl::bn::G2 GetBase() {
                 mcl::bn::G2 baseG2;
                 mcl::bn::mapToG2(baseG2, 1);
                 return baseG2;
             }
 
-            PublicKey() {};
-            PublicKey(mcl::bn::G2 v): v(v) {};
+            PublicKeyT() {};
+            PublicKeyT(mcl::bn::G2 v): v(v) {};
 
             bool operator==(const PublicKey& other) const {
                 return v == other.v;
@@ -56,16 +213,69 @@ namespace libjodi {
             mcl::bn::G2 v;
     };
 
-    class PrivateKey {
-        static const int SK_SIZE = 32;
+    /**
+     * Verifier-side public key. The G2 generator and the Miller-loop line
+     * coefficients of pk and of the generator are computed once, so each
+     * verification only pays for the G1 side of its pairings.
+     */
+    template <class Curve>
+    class PreparedPublicKeyT : private CurveGuard<Curve> {
+        typedef PublicKeyT<Curve> PublicKey;
+
+        public:
+            PreparedPublicKeyT() {};
+
+            explicit PreparedPublicKeyT(const PublicKey& pk): pk(pk), base(PublicKey::GetBase()) {
+                mcl::bn::precomputeG2(pkCoeff, pk.GetG2());
+                mcl::bn::precomputeG2(baseCoeff, base);
+            }
+
+            const PublicKey& GetPublicKey() const {
+                return pk;
+            }
+
+            const mcl::bn::G2& GetBase() const {
+                return base;
+            }
+
+            const std::vector<mcl::bn::Fp6>& GetKeyCoeff() const {
+                return pkCoeff;
+            }
+
+            const std::vector<mcl::bn::Fp6>& GetBaseCoeff() const {
+                return baseCoeff;
+            }
+        private:
+            PublicKey pk;
+            mcl::bn::G2 base;
+            std::vector<mcl::bn::Fp6> pkCoeff;
+            std::vector<mcl::bn::Fp6> baseCoeff;
+    };
+
+    template <class Curve>
+    class PrivateKeyT : private CurveGuard<Curve> {
+        typedef PublicKeyT<Curve> PublicKey;
+        typedef PrivateKeyT<Curve> PrivateKey;
 
         public:
-            PrivateKey() {};
+            static constexpr size_t SERIALIZED_SIZE = Curve::FR_SIZE;
+
+            size_t SerializeTo(uint8_t* buf, size_t len) const {
+                return serializeFixed(s, buf, len, SERIALIZED_SIZE, "PrivateKey::SerializeTo");
+            }
+
+            static PrivateKey DeserializeFrom(const uint8_t* buf, size_t len) {
+                PrivateKey sk;
+                deserializeFixed(sk.s, buf, len, SERIALIZED_SIZE, "PrivateKey::DeserializeFrom");
+                return sk;
+            }
+
+            PrivateKeyT() {};
             
-            PrivateKey(mcl::bn::Fr s): s(s) {};
+            PrivateKeyT(mcl::bn::Fr s): s(s) {};
 
             Bytes ToBytes() const {
-                uint8_t buf[SK_SIZE];
+                uint8_t buf[SERIALIZED_SIZE];
                 size_t len = s.serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
@@ -93,7 +303,7 @@ namespace libjodi {
 
             PublicKey GetPublicKey() const {
                 mcl::bn::G2 vk;
-                mcl::bn::G2::mul(vk, PublicKey::GetBase(), s);
+                scalarMul(vk, PublicKey::GetBase(), s, ExecutionMode::SecretInputs);
                 return PublicKey(vk);
             }
 
@@ -114,16 +324,95 @@ namespace libjodi {
             mcl::bn::Fr s;
     };
 
-    class Point {
-        static const int MAX_Pt_SIZE = 128;
+    template <class Curve>
+    PublicKeyT<Curve> PublicKeyT<Curve>::MulVec(const vector<PublicKey>& pks, const vector<PrivateKey>& ks, WorkerPool& pool) {
+        if (pks.size() != ks.size()) {
+            throw std::invalid_argument("PublicKey::MulVec: keys and scalars differ in size");
+        }
+
+        vector<mcl::bn::G2> points(pks.size());
+        vector<mcl::bn::Fr> scalars(ks.size());
+        for (size_t i = 0; i < pks.size(); i++) {
+            points[i] = pks[i].v;
+            scalars[i] = ks[i].GetFr();
+        }
+
+        mcl::bn::G2 v;
+        mulVecSplit(v, points.data(), scalars.data(), points.size(), pool);
+        return PublicKey(v);
+    }
+
+    template <class Curve>
+    class PointT : private CurveGuard<Curve> {
+        typedef PointT<Curve> Point;
+        typedef PrivateKeyT<Curve> PrivateKey;
 
         public:
-            Point() {};
+            // Compressed G1 point
+            static constexpr size_t SERIALIZED_SIZE = Curve::G1_SIZE;
+
+            size_t SerializeTo(uint8_t* buf, size_t len) const {
+                return serializeFixed(v, buf, len, SERIALIZED_SIZE, "Point::SerializeTo");
+            }
+
+            static Point DeserializeFrom(const uint8_t* buf, size_t len) {
+                Point p;
+                deserializeFixed(p.v, buf, len, SERIALIZED_SIZE, "Point::DeserializeFrom");
+                return p;
+            }
+
+            // Batch encoding: count (LE32) followed by count fixed-size points
+            static size_t SerializedVectorSize(size_t count) {
+                return 4 + count * SERIALIZED_SIZE;
+            }
+
+            static size_t SerializeVector(const vector<Point>& points, uint8_t* buf, size_t len) {
+                size_t total = SerializedVectorSize(points.size());
+                if (len < total || points.size() > UINT32_MAX) {
+                    throw std::invalid_argument("Point::SerializeVector: buffer too small");
+                }
 
-            Point(mcl::bn::G1 v): v(v) {};
+                uint32_t count = (uint32_t)points.size();
+                for (int b = 0; b < 4; b++) buf[b] = (uint8_t)(count >> (8 * b));
+
+                uint8_t* out = buf + 4;
+                for (const auto& p : points) {
+                    out += p.SerializeTo(out, SERIALIZED_SIZE);
+                }
+                return total;
+            }
+
+            // consumed, if given, receives the number of bytes read
+            static vector<Point> DeserializeVector(const uint8_t* buf, size_t len, size_t* consumed = nullptr) {
+                if (len < 4) {
+                    throw std::invalid_argument("Point::DeserializeVector: truncated input");
+                }
+
+                uint32_t count = 0;
+                for (int b = 0; b < 4; b++) count |= (uint32_t)buf[b] << (8 * b);
+
+                if ((len - 4) / SERIALIZED_SIZE < count) {
+                    throw std::invalid_argument("Point::DeserializeVector: truncated input");
+                }
+
+                vector<Point> points(count);
+                const uint8_t* in = buf + 4;
+                for (auto& p : points) {
+                    p = DeserializeFrom(in, SERIALIZED_SIZE);
+                    in += SERIALIZED_SIZE;
+                }
+
+                if (consumed) *consumed = SerializedVectorSize(count);
+                return points;
+            }
+
+            // The identity, so an unset point is never mistaken for a hash
+            PointT() { v.clear(); };
+
+            PointT(mcl::bn::G1 v): v(v) {};
 
             Bytes ToBytes() const {
-                uint8_t buf[MAX_Pt_SIZE];
+                uint8_t buf[SERIALIZED_SIZE];
                 size_t len = v.serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
@@ -150,9 +439,59 @@ namespace libjodi {
                 return Point(v);
             }
 
-            static Point Mul(const Point& p, const PrivateKey& sk) {
+            static constexpr const char* HASH_TO_CURVE_DST = Curve::HASH_TO_CURVE_DST;
+            static constexpr size_t HASH_TO_FIELD_LEN = Curve::HASH_TO_FIELD_LEN;
+
+            /**
+             * hash_to_curve in the shape of RFC 9380: expand_message_xmd
+             * (SHA-256) yields two field elements, each is mapped to G1 and
+             * the two points are added, so the result is a random-oracle
+             * hash rather than a plain encoding. mcl's mapToG1 serves as the
+             * map on either curve (BN254 has no standard SSWU isogeny), so
+             * outputs do not match the RFC 9380 suites, and the default DSTs
+             * are deliberately not named like suite IDs.
+             */
+            static Point HashToCurve(const string& m, const string& dst = HASH_TO_CURVE_DST) {
+                Bytes uniform = Utils::ExpandMessageXmd(Bytes(m.begin(), m.end()), dst, 2 * HASH_TO_FIELD_LEN);
+
+                mcl::bn::Fp u0, u1;
+                u0.setBigEndianMod(uniform.data(), HASH_TO_FIELD_LEN);
+                u1.setBigEndianMod(uniform.data() + HASH_TO_FIELD_LEN, HASH_TO_FIELD_LEN);
+
+                mcl::bn::G1 q0, q1;
+                mcl::bn::mapToG1(q0, u0);
+                mcl::bn::mapToG1(q1, u1);
+                mcl::bn::G1::add(q0, q0, q1);
+                return Point(q0);
+            }
+
+            static Point Mul(const Point& p, const PrivateKey& sk, ExecutionMode mode = ExecutionMode::SecretInputs) {
                 mcl::bn::G1 v;
-                mcl::bn::G1::mul(v, p.v, sk.GetFr());
+                scalarMul(v, p.v, sk.GetFr(), mode);
+                return Point(v);
+            }
+
+            // sum ks[i] * ps[i]; variable-time, for public scalars
+            static Point MulVec(const vector<Point>& ps, const vector<PrivateKey>& ks, WorkerPool& pool = WorkerPool::GetDefault()) {
+                if (ps.size() != ks.size()) {
+                    throw std::invalid_argument("Point::MulVec: points and scalars differ in size");
+                }
+
+                vector<mcl::bn::G1> points(ps.size());
+                vector<mcl::bn::Fr> scalars(ks.size());
+                for (size_t i = 0; i < ps.size(); i++) {
+                    points[i] = ps[i].v;
+                    scalars[i] = ks[i].GetFr();
+                }
+
+                mcl::bn::G1 v;
+                mulVecSplit(v, points.data(), scalars.data(), points.size(), pool);
+                return Point(v);
+            }
+
+            static Point Neg(const Point& p) {
+                mcl::bn::G1 v;
+                mcl::bn::G1::neg(v, p.v);
                 return Point(v);
             }
 
@@ -160,6 +499,10 @@ namespace libjodi {
                 return v;
             }
 
+            bool IsZero() const {
+                return v.isZero();
+            }
+
             bool operator==(const Point& other) const {
                 return v == other.v;
             }
@@ -171,11 +514,167 @@ namespace libjodi {
             mcl::bn::G1 v;
     };
 
-    class Pairing {
+    /**
+     * Opt-in bounded LRU of Point::HashToPoint results, for public messages
+     * that are verified many times. Do not feed it secret inputs: entries
+     * stay in memory until evicted.
+     */
+    template <class Curve>
+    class HashedPointCacheT : private CurveGuard<Curve> {
+        typedef PointT<Curve> Point;
+
         public:
-            Pairing() {};
+            explicit HashedPointCacheT(size_t capacity = 4096): capacity(capacity) {
+                if (capacity == 0) {
+                    throw std::invalid_argument("HashedPointCache: capacity must be positive");
+                }
+            }
+
+            HashedPointCacheT(HashedPointCacheT const&) = delete;
+            HashedPointCacheT& operator=(HashedPointCacheT const&) = delete;
+
+            Point Get(const string& m) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = index.find(m);
+                    if (it != index.end()) {
+                        lru.splice(lru.begin(), lru, it->second);
+                        hits++;
+                        return it->second->second;
+                    }
+                    misses++;
+                }
+
+                // Hash outside the lock; a racing insert of the same message is harmless
+                Point p = Point::HashToPoint(m);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (index.find(m) == index.end()) {
+                    if (lru.size() >= capacity) {
+                        index.erase(lru.back().first);
+                        lru.pop_back();
+                    }
+                    lru.emplace_front(m, p);
+                    index.emplace(m, lru.begin());
+                }
+                return p;
+            }
 
-            Pairing(mcl::bn::Fp12 e): e(e) {};
+            size_t Size() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return lru.size();
+            }
+
+            uint64_t GetHits() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return hits;
+            }
+
+            uint64_t GetMisses() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return misses;
+            }
+        private:
+            size_t capacity;
+            std::mutex mutex;
+            std::list<std::pair<string, Point>> lru;   // most recently used first
+            std::unordered_map<string, typename std::list<std::pair<string, Point>>::iterator> index;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+    };
+
+    template <class Curve>
+    class PairingT : private CurveGuard<Curve> {
+        typedef PairingT<Curve> Pairing;
+        typedef PointT<Curve> Point;
+        typedef PublicKeyT<Curve> PublicKey;
+
+        public:
+            // Flag byte plus one Fp6 value, half the size of a raw Fp12
+            static constexpr size_t SERIALIZED_SIZE = 1 + 6 * Curve::FP_SIZE;
+
+            PairingT() {};
+
+            PairingT(mcl::bn::Fp12 e): e(e) {};
+
+            /**
+             * GT elements are unitary in Fp12 = Fp6[w]/(w^2 - v), so they
+             * compress to the torus T2: g = a + b*w maps to c = (1 + a) / b and
+             * comes back as (c + w) / (c - w). The flag byte covers b == 0,
+             * where g is +1 or -1.
+             */
+            size_t SerializeTo(uint8_t* buf, size_t len) const {
+                if (len < SERIALIZED_SIZE) {
+                    throw std::invalid_argument("Pairing::SerializeTo: buffer too small");
+                }
+
+                mcl::bn::Fp6 one = fp6One();
+                if (e.b.isZero()) {
+                    mcl::bn::Fp6 minusOne;
+                    mcl::bn::Fp6::neg(minusOne, one);
+                    if (e.a != one && e.a != minusOne) {
+                        throw std::invalid_argument("Pairing::SerializeTo: not a GT element");
+                    }
+                    buf[0] = e.a == one ? FLAG_ONE : FLAG_MINUS_ONE;
+                    std::fill(buf + 1, buf + SERIALIZED_SIZE, 0);
+                    return SERIALIZED_SIZE;
+                }
+
+                mcl::bn::Fp6 c, binv;
+                mcl::bn::Fp6::add(c, one, e.a);
+                mcl::bn::Fp6::inv(binv, e.b);
+                mcl::bn::Fp6::mul(c, c, binv);
+
+                buf[0] = FLAG_TORUS;
+                serializeFixed(c, buf + 1, len - 1, SERIALIZED_SIZE - 1, "Pairing::SerializeTo");
+                return SERIALIZED_SIZE;
+            }
+
+            static Pairing DeserializeFrom(const uint8_t* buf, size_t len) {
+                if (len < SERIALIZED_SIZE) {
+                    throw std::invalid_argument("Pairing::DeserializeFrom: invalid encoding");
+                }
+
+                mcl::bn::Fp6 one = fp6One();
+                mcl::bn::Fp12 e;
+                switch (buf[0]) {
+                    case FLAG_ONE:
+                        e.a = one;
+                        e.b.clear();
+                        break;
+                    case FLAG_MINUS_ONE:
+                        mcl::bn::Fp6::neg(e.a, one);
+                        e.b.clear();
+                        break;
+                    case FLAG_TORUS: {
+                        mcl::bn::Fp6 c;
+                        deserializeFixed(c, buf + 1, len - 1, SERIALIZED_SIZE - 1, "Pairing::DeserializeFrom");
+
+                        // (c + w) / (c - w)
+                        mcl::bn::Fp12 num, den;
+                        num.a = c;
+                        num.b = one;
+                        den.a = c;
+                        mcl::bn::Fp6::neg(den.b, one);
+                        mcl::bn::Fp12::inv(den, den);
+                        mcl::bn::Fp12::mul(e, num, den);
+                        break;
+                    }
+                    default:
+                        throw std::invalid_argument("Pairing::DeserializeFrom: invalid encoding");
+                }
+                return Pairing(e);
+            }
+
+            Bytes ToBytes() const {
+                Bytes out(SERIALIZED_SIZE);
+                SerializeTo(out.data(), out.size());
+                return out;
+            }
+
+            static Pairing FromBytes(const Bytes& bytes) {
+                return DeserializeFrom(bytes.data(), bytes.size());
+            }
 
             string ToString() const {
                 return e.getStr();
@@ -193,12 +692,75 @@ namespace libjodi {
                 return Pairing(e);
             }
 
+            /**
+             * True iff prod e(xs[i], pks[i]) == 1. All Miller loops share one
+             * accumulator and there is a single final exponentiation, so an
+             * equation e(a, b) == e(c, d) is checked as e(a, b) * e(-c, d) == 1
+             * at roughly the cost of one pairing.
+             */
+            static bool ProductIsOne(const vector<Point>& xs, const vector<PublicKey>& pks) {
+                if (xs.size() != pks.size()) {
+                    throw std::invalid_argument("Pairing::ProductIsOne: xs and pks differ in size");
+                }
+
+                vector<mcl::bn::G1> g1(xs.size());
+                vector<mcl::bn::G2> g2(pks.size());
+                for (size_t i = 0; i < xs.size(); i++) {
+                    g1[i] = xs[i].GetG1();
+                    g2[i] = pks[i].GetG2();
+                }
+                return ProductIsOne(g1.data(), g2.data(), g1.size());
+            }
+
+            static bool ProductIsOne(const Point& x1, const PublicKey& pk1, const Point& x2, const PublicKey& pk2) {
+                mcl::bn::G1 g1[2] = { x1.GetG1(), x2.GetG1() };
+                mcl::bn::G2 g2[2] = { pk1.GetG2(), pk2.GetG2() };
+                return ProductIsOne(g1, g2, 2);
+            }
+
+            // Same check against precomputed G2 line coefficients
+            static bool ProductIsOne(const Point& x1, const std::vector<mcl::bn::Fp6>& q1,
+                                     const Point& x2, const std::vector<mcl::bn::Fp6>& q2) {
+                mcl::bn::Fp12 e;
+                mcl::bn::precomputedMillerLoop2(e, x1.GetG1(), q1, x2.GetG1(), q2);
+                mcl::bn::finalExp(e, e);
+                return e.isOne();
+            }
+
+            static bool ProductIsOne(const mcl::bn::G1* xs, const mcl::bn::G2* qs, size_t n) {
+                if (n == 0) return true;
+
+                mcl::bn::Fp12 e;
+                mcl::bn::millerLoopVec(e, xs, qs, n);
+                mcl::bn::finalExp(e, e);
+                return e.isOne();
+            }
+
             bool operator==(const Pairing& other) const {
                 return e == other.e;
             }
         private:
+            static constexpr uint8_t FLAG_TORUS = 0;
+            static constexpr uint8_t FLAG_ONE = 1;
+            static constexpr uint8_t FLAG_MINUS_ONE = 2;
+
             mcl::bn::Fp12 e;
+
+            static mcl::bn::Fp6 fp6One() {
+                mcl::bn::Fp6 one;
+                one.clear();
+                one.a.a = 1;
+                return one;
+            }
     };
+
+    // The curve chosen for this build; see JODI_CURVE_BLS12_381
+    typedef PublicKeyT<DefaultCurve> PublicKey;
+    typedef PreparedPublicKeyT<DefaultCurve> PreparedPublicKey;
+    typedef PrivateKeyT<DefaultCurve> PrivateKey;
+    typedef PointT<DefaultCurve> Point;
+    typedef HashedPointCacheT<DefaultCurve> HashedPointCache;
+    typedef PairingT<DefaultCurve> Pairing;
 }
 
 #endif // PAIRING_HPP
\ No newline at end of file
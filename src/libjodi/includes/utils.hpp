@@ -12,11 +12,19 @@ namespace libjodi {
 
             static Bytes Sha160(Bytes const & preimage);
             static Bytes Sha256(Bytes const & preimage);
+            // expand_message_xmd from RFC 9380 with SHA-256; len <= 8160
+            static Bytes ExpandMessageXmd(Bytes const & msg, string const & dst, size_t len);
 
             static string EncodeBase64(Bytes const & data);
             static Bytes DecodeBase64(string const & data);
 
+            // The shorter input is treated as zero-padded to the longer one
             static Bytes Xor(Bytes const & x, Bytes const & y);
+            // dst ^= src; dst grows with zeros if src is longer
+            static void XorInto(Bytes & dst, Bytes const & src);
+            static void XorInto(unsigned char *dst, const unsigned char *src, size_t len);
+            // Kernel picked for this CPU: "avx2", "sse2", "neon" or "scalar"
+            static const char *XorKernel();
             static Bytes RemoveTrailingZeroes(Bytes & data);
 
             static Bytes RandomBytes(size_t size);
@@ -5,28 +5,131 @@
 #include "pairing.hpp"
 
 namespace libjodi {
-    class VOPRF_Blinded {
+    template <class Curve>
+    class VOPRF_BlindedT : private CurveGuard<Curve> {
+        typedef PrivateKeyT<Curve> PrivateKey;
+        typedef PointT<Curve> Point;
+
         public:
             PrivateKey r;
             Point x;
+            // HashToPoint(msg), reusable by VerifyHashed; zero when unknown,
+            // which VerifyHashed rejects
+            Point h;
+
+            VOPRF_BlindedT() {};
+            VOPRF_BlindedT(PrivateKey r, Point x, Point h = Point()): r(r), x(x), h(h) {};
+            VOPRF_BlindedT(Point x, PrivateKey r, Point h = Point()): r(r), x(x), h(h) {};
+    };
+
+    // Blinded messages of one BlindBatch call. Only the inverses of the
+    // blinding factors are kept, since that is all unblinding needs.
+    template <class Curve>
+    class VOPRF_BlindedBatchT : private CurveGuard<Curve> {
+        typedef PrivateKeyT<Curve> PrivateKey;
+        typedef PointT<Curve> Point;
+
+        public:
+            vector<Point> xs;
+            vector<PrivateKey> rInv;
+
+            VOPRF_BlindedBatchT() {};
+
+            size_t Size() const { return xs.size(); }
+    };
+
+    // Shamir share f(index) of a VOPRF key, with pk = f(index) * g2 so clients
+    // can check partial evaluations from the node holding it
+    template <class Curve>
+    class VOPRF_KeyShareT : private CurveGuard<Curve> {
+        typedef PublicKeyT<Curve> PublicKey;
+        typedef PrivateKeyT<Curve> PrivateKey;
+
+        public:
+            uint32_t index = 0;
+            PrivateKey share;
+            PublicKey pk;
 
-            VOPRF_Blinded() {};
-            VOPRF_Blinded(PrivateKey r, Point x): r(r), x(x) {};
-            VOPRF_Blinded(Point x, PrivateKey r): x(x), r(r) {};
+            VOPRF_KeyShareT() {};
+            VOPRF_KeyShareT(uint32_t index, PrivateKey share, PublicKey pk): index(index), share(share), pk(pk) {};
     };
 
-    class VOPRF {
+    template <class Curve>
+    class VOPRF_PartialEvalT : private CurveGuard<Curve> {
+        typedef PointT<Curve> Point;
+
+        public:
+            uint32_t index = 0;
+            Point fx;
+
+            VOPRF_PartialEvalT() {};
+            VOPRF_PartialEvalT(uint32_t index, Point fx): index(index), fx(fx) {};
+    };
+
+    /**
+     * Blind, Unblind and Evaluate handle secrets and run in
+     * ExecutionMode::SecretInputs. The Verify* functions only see public
+     * values and use variable-time arithmetic (ExecutionMode::PublicInputs).
+     *
+     * voprf.cpp instantiates DefaultCurve only.
+     */
+    template <class Curve>
+    class VOPRFT : private CurveGuard<Curve> {
         public:
+            typedef PublicKeyT<Curve> PublicKey;
+            typedef PreparedPublicKeyT<Curve> PreparedPublicKey;
+            typedef PrivateKeyT<Curve> PrivateKey;
+            typedef PointT<Curve> Point;
+            typedef HashedPointCacheT<Curve> HashedPointCache;
+            typedef PairingT<Curve> Pairing;
+            typedef VOPRF_BlindedT<Curve> VOPRF_Blinded;
+            typedef VOPRF_BlindedBatchT<Curve> VOPRF_BlindedBatch;
+            typedef VOPRF_KeyShareT<Curve> VOPRF_KeyShare;
+            typedef VOPRF_PartialEvalT<Curve> VOPRF_PartialEval;
+
             static VOPRF_Blinded Blind(const string &msg);
 
             static Point Unblind(const Point& fx, const PrivateKey& r);
 
+            // Batch variants: hashing and G1 multiplications run on the pool,
+            // and all blinding factors are inverted with one field inversion
+            // per worker (Montgomery's trick)
+            static VOPRF_BlindedBatch BlindBatch(const vector<string>& msgs, WorkerPool& pool = WorkerPool::GetDefault());
+            static vector<Point> UnblindBatch(const vector<Point>& fxs, const VOPRF_BlindedBatch& blinded, WorkerPool& pool = WorkerPool::GetDefault());
+
             static Point Evaluate(const PrivateKey& sk, const Point& x);
             static bool Verify(const PublicKey& pk, const string& x, const Point& fx);
-        
+            static bool Verify(const PreparedPublicKey& pk, const string& x, const Point& fx);
+            static bool Verify(const PreparedPublicKey& pk, HashedPointCache& cache, const string& x, const Point& fx);
+            // For callers that already hold HashToPoint(x), e.g. from Blind.
+            // The identity is never a valid hash or output and is rejected.
+            static bool VerifyHashed(const PreparedPublicKey& pk, const Point& hx, const Point& fx);
+
+            // Checks every ys[i] against msgs[i] with one random linear
+            // combination and a single final exponentiation. On failure, the
+            // indices of the bad outputs are written to failed if given.
+            static bool VerifyBatch(const PublicKey& pk, const vector<string>& msgs, const vector<Point>& ys, vector<size_t>* failed = nullptr);
+            static bool VerifyBatch(const PreparedPublicKey& pk, const vector<string>& msgs, const vector<Point>& ys, vector<size_t>* failed = nullptr);
+
+            // Threshold mode: any t of the n shares evaluate, and Combine
+            // interpolates their outputs to sk * x at zero
+            static vector<VOPRF_KeyShare> SplitKey(const PrivateKey& sk, size_t t, size_t n);
+            static VOPRF_PartialEval EvaluatePartial(const VOPRF_KeyShare& share, const Point& x);
+            static bool VerifyPartial(const PublicKey& sharePk, const Point& x, const VOPRF_PartialEval& partial);
+            // Uses the first t partials; their indices must be distinct
+            static Point Combine(const vector<VOPRF_PartialEval>& partials, size_t t);
+
         private:
-            VOPRF() {};
+            VOPRFT() {};
     };
+
+    typedef VOPRF_BlindedT<DefaultCurve> VOPRF_Blinded;
+    typedef VOPRF_BlindedBatchT<DefaultCurve> VOPRF_BlindedBatch;
+    typedef VOPRF_KeyShareT<DefaultCurve> VOPRF_KeyShare;
+    typedef VOPRF_PartialEvalT<DefaultCurve> VOPRF_PartialEval;
+    typedef VOPRFT<DefaultCurve> VOPRF;
+
+    extern template class VOPRFT<DefaultCurve>;
 }
 
 #endif // VOPRF_HPP
\ No newline at end of file
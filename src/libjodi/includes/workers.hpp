@@ -0,0 +1,52 @@
+#ifndef JODI_WORKERS_HPP
+#define JODI_WORKERS_HPP
+
+#include "base.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace libjodi {
+    /**
+     * Fixed-size pool of worker threads shared by the batch APIs.
+     * ParallelFor splits [0, count) into contiguous ranges and the calling
+     * thread always works on one of them, so a pool of size 0 runs inline.
+     */
+    class WorkerPool {
+        public:
+            // numThreads == 0 sizes the pool to hardware_concurrency() - 1
+            explicit WorkerPool(size_t numThreads = 0);
+            ~WorkerPool();
+
+            WorkerPool(WorkerPool const&) = delete;
+            WorkerPool& operator=(WorkerPool const&) = delete;
+
+            static WorkerPool& GetDefault() {
+                static WorkerPool instance;
+                return instance;
+            }
+
+            size_t GetSize() const { return workers.size(); }
+
+            // Minimum items per range for cheap per-item work, below which the
+            // cost of handing a range to another worker dominates
+            static const size_t DEFAULT_MIN_CHUNK = 16;
+
+            // Calls fn(begin, end) over disjoint ranges covering [0, count), with
+            // at least minChunk items per range. Rethrows the first exception.
+            void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t minChunk = 1);
+
+        private:
+            std::vector<std::thread> workers;
+            std::queue<std::function<void()>> tasks;
+            std::mutex tasksMutex;
+            std::condition_variable tasksCv;
+            bool stopping = false;
+
+            bool RunPendingTask();
+    };
+}
+
+#endif // JODI_WORKERS_HPP
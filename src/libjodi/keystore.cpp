@@ -0,0 +1,210 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "libjodi.hpp"
+
+namespace libjodi
+{
+// Layout (all integers little-endian):
+//   magic[8] | version u32 | keyCount u32 | epoch u64 | expiryIndex i32 |
+//   recentlyExpiredIndex i32 | recentlyExpiredTime i64 ms | rotationTime i64 ms |
+//   recentlyExpired sk[32] pk[32] | keyCount * (sk[32] pk[32]) | checksum[32]
+static const unsigned char KEYSTORE_MAGIC[8] = {'J', 'O', 'D', 'I', 'K', 'E', 'Y', 'S'};
+static const size_t KEYSTORE_HEADER_SIZE = 8 + 4 + 4 + 8 + 4 + 4 + 8 + 8;
+static const size_t KEYSTORE_KEY_SIZE = crypto_core_ristretto255_SCALARBYTES + crypto_core_ristretto255_BYTES;
+static const size_t KEYSTORE_CHECKSUM_SIZE = crypto_generichash_BYTES;
+
+static void putLE(Bytes &out, uint64_t v, int width)
+{
+    for (int b = 0; b < width; ++b) out.push_back((unsigned char)(v >> (8 * b)));
+}
+
+static uint64_t getLE(const unsigned char *p, int width)
+{
+    uint64_t v = 0;
+    for (int b = 0; b < width; ++b) v |= (uint64_t)p[b] << (8 * b);
+    return v;
+}
+
+static int64_t toMillis(std::chrono::system_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+static std::chrono::system_clock::time_point fromMillis(int64_t ms)
+{
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+}
+
+static void putKey(Bytes &out, const OPRF_Keypair &key)
+{
+    if (key.sk.size() != crypto_core_ristretto255_SCALARBYTES || key.pk.size() != crypto_core_ristretto255_BYTES) {
+        throw std::invalid_argument("KeyStore::Save: invalid key size");
+    }
+    out.insert(out.end(), key.sk.begin(), key.sk.end());
+    out.insert(out.end(), key.pk.begin(), key.pk.end());
+}
+
+static OPRF_Keypair getKey(const unsigned char *p)
+{
+    const unsigned char *pk = p + crypto_core_ristretto255_SCALARBYTES;
+    return OPRF_Keypair(Bytes(p, pk), Bytes(pk, pk + crypto_core_ristretto255_BYTES));
+}
+
+static void writeAll(int fd, const Bytes &data, const std::string &path)
+{
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("KeyStore: write " + path + ": " + std::strerror(errno));
+        }
+        done += (size_t)n;
+    }
+}
+
+KeyStore::KeyStore(const std::string &path) : path(path)
+{
+    if (path.empty()) {
+        throw std::invalid_argument("KeyStore: empty path");
+    }
+}
+
+void KeyStore::Save(const KeyRing &ring) const
+{
+    Bytes data;
+    data.reserve(KEYSTORE_HEADER_SIZE + (ring.keys.size() + 1) * KEYSTORE_KEY_SIZE + KEYSTORE_CHECKSUM_SIZE);
+
+    data.insert(data.end(), KEYSTORE_MAGIC, KEYSTORE_MAGIC + sizeof(KEYSTORE_MAGIC));
+    putLE(data, VERSION, 4);
+    putLE(data, ring.keys.size(), 4);
+    putLE(data, ring.epoch, 8);
+    putLE(data, (uint32_t)ring.expiryIndex, 4);
+    putLE(data, (uint32_t)ring.recentlyExpiredIndex, 4);
+    putLE(data, (uint64_t)toMillis(ring.recentlyExpiredTime), 8);
+    putLE(data, (uint64_t)toMillis(ring.rotationTime), 8);
+
+    if (ring.recentlyExpiredIndex >= 0) {
+        putKey(data, ring.recentlyExpiredKey);
+    } else {
+        data.resize(data.size() + KEYSTORE_KEY_SIZE, 0);
+    }
+    for (const auto &key : ring.keys) {
+        putKey(data, key);
+    }
+
+    unsigned char checksum[KEYSTORE_CHECKSUM_SIZE];
+    crypto_generichash(checksum, sizeof(checksum), data.data(), data.size(), nullptr, 0);
+    data.insert(data.end(), checksum, checksum + sizeof(checksum));
+
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        sodium_memzero(data.data(), data.size());
+        throw std::runtime_error("KeyStore: open " + tmpPath + ": " + std::strerror(errno));
+    }
+
+    try {
+        writeAll(fd, data, tmpPath);
+        if (fsync(fd) != 0) {
+            throw std::runtime_error("KeyStore: fsync " + tmpPath + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        sodium_memzero(data.data(), data.size());
+        close(fd);
+        unlink(tmpPath.c_str());
+        throw;
+    }
+    sodium_memzero(data.data(), data.size());
+    close(fd);
+
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        unlink(tmpPath.c_str());
+        throw std::runtime_error("KeyStore: rename " + tmpPath + ": " + std::strerror(err));
+    }
+
+    // Persist the rename itself
+    auto slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+}
+
+KeyRingSnapshot KeyStore::Load() const
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) return nullptr;
+        throw std::runtime_error("KeyStore: open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("KeyStore: stat " + path + ": " + std::strerror(err));
+    }
+
+    size_t fileSize = (size_t)st.st_size;
+    if (fileSize < KEYSTORE_HEADER_SIZE + KEYSTORE_KEY_SIZE + KEYSTORE_CHECKSUM_SIZE) {
+        close(fd);
+        return nullptr;
+    }
+
+    void *mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("KeyStore: mmap " + path + ": " + std::strerror(errno));
+    }
+
+    const unsigned char *p = static_cast<const unsigned char *>(mapped);
+    std::shared_ptr<KeyRing> ring;
+
+    size_t keyCount = (size_t)getLE(p + 12, 4);
+    size_t bodySize = KEYSTORE_HEADER_SIZE + (keyCount + 1) * KEYSTORE_KEY_SIZE;
+
+    unsigned char checksum[KEYSTORE_CHECKSUM_SIZE];
+    if (std::memcmp(p, KEYSTORE_MAGIC, sizeof(KEYSTORE_MAGIC)) == 0 &&
+        getLE(p + 8, 4) == VERSION &&
+        bodySize + KEYSTORE_CHECKSUM_SIZE == fileSize &&
+        crypto_generichash(checksum, sizeof(checksum), p, bodySize, nullptr, 0) == 0 &&
+        sodium_memcmp(checksum, p + bodySize, sizeof(checksum)) == 0) {
+
+        ring = std::make_shared<KeyRing>();
+        ring->epoch = getLE(p + 16, 8);
+        ring->expiryIndex = (int32_t)getLE(p + 24, 4);
+        ring->recentlyExpiredIndex = (int32_t)getLE(p + 28, 4);
+        ring->recentlyExpiredTime = fromMillis((int64_t)getLE(p + 32, 8));
+        ring->rotationTime = fromMillis((int64_t)getLE(p + 40, 8));
+
+        const unsigned char *keys = p + KEYSTORE_HEADER_SIZE;
+        if (ring->recentlyExpiredIndex >= 0) {
+            ring->recentlyExpiredKey = getKey(keys);
+        }
+        ring->keys.reserve(keyCount);
+        for (size_t i = 0; i < keyCount; ++i) {
+            ring->keys.push_back(getKey(keys + (i + 1) * KEYSTORE_KEY_SIZE));
+        }
+
+        // The checksum is unkeyed, so a crafted file passes it; indices must
+        // still be -1 (nothing rotated yet) or name a slot, and the ring
+        // must not be empty since rotation works modulo its size
+        auto validIndex = [keyCount](int index) { return index >= -1 && index < (int)keyCount; };
+        if (keyCount == 0 || !validIndex(ring->expiryIndex) || !validIndex(ring->recentlyExpiredIndex)) {
+            ring.reset();
+        }
+    }
+
+    munmap(mapped, fileSize);
+    return ring;
+}
+
+} // namespace libjodi
@@ -0,0 +1,149 @@
+#include <cstring>
+#include "libjodi.hpp"
+
+namespace libjodi
+{
+size_t LabelCache::KeyHash::operator()(const Key &key) const
+{
+    // The digest is already uniformly distributed
+    size_t h;
+    std::memcpy(&h, key.digest.data(), sizeof(h));
+    return h ^ (size_t)key.keyIndex;
+}
+
+LabelCache::LabelCache(std::shared_ptr<KeyRotation> rotation, size_t capacity, size_t numShards, int tmax)
+    : rotation(std::move(rotation)), capacity(capacity), tmax(tmax), numShards(numShards)
+{
+    if (!this->rotation) {
+        throw std::invalid_argument("LabelCache: no KeyRotation given");
+    }
+    if (capacity == 0 || numShards == 0) {
+        throw std::invalid_argument("LabelCache: capacity and shard count must be positive");
+    }
+
+    shardCapacity = (capacity + numShards - 1) / numShards;
+    shards.reset(new Shard[numShards]);
+    crypto_generichash_keygen(hashKey);
+}
+
+LabelCache::Key LabelCache::MakeKey(const string &callDetails, int keyIndex) const
+{
+    Key key;
+    key.keyIndex = keyIndex;
+    crypto_generichash(key.digest.data(), key.digest.size(),
+                       reinterpret_cast<const unsigned char *>(callDetails.data()), callDetails.size(),
+                       hashKey, sizeof(hashKey));
+    return key;
+}
+
+LabelCache::Shard &LabelCache::ShardFor(const Key &key) const
+{
+    // Use digest bytes the map hash does not, so shards and buckets stay independent
+    uint32_t h;
+    std::memcpy(&h, key.digest.data() + sizeof(size_t), sizeof(h));
+    return shards[h % numShards];
+}
+
+bool LabelCache::IsValid(int index, const Bytes &vk, const KeyRing &ring) const
+{
+    if (index < 0 || index >= (int)ring.keys.size()) return false;
+
+    // Still the live key in its slot
+    if (ring.keys[index].pk == vk) return true;
+
+    // Rotated out on the last tick but still inside the grace window
+    return index == ring.recentlyExpiredIndex &&
+           ring.recentlyExpiredKey.pk == vk &&
+           ring.IsExpiredWithin(index, tmax);
+}
+
+bool LabelCache::Get(const string &callDetails, int keyIndex, Bytes &label)
+{
+    Key key = MakeKey(callDetails, keyIndex);
+    auto ring = rotation->GetSnapshot();
+    Shard &shard = ShardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (!IsValid(key.keyIndex, it->second->vk, *ring)) {
+        sodium_memzero(it->second->label.data(), it->second->label.size());
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    label = it->second->label;
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void LabelCache::Put(const string &callDetails, int keyIndex, const Bytes &vk, const Bytes &label)
+{
+    // The slot may have rotated since the label was evaluated; a label from
+    // a key that is no longer accepted must not be pinned to the new one
+    auto ring = rotation->GetSnapshot();
+    if (!IsValid(keyIndex, vk, *ring)) {
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Key key = MakeKey(callDetails, keyIndex);
+    Shard &shard = ShardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        Entry &entry = *it->second;
+        entry.vk = vk;
+        entry.label = label;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    if (shard.lru.size() >= shardCapacity) {
+        Entry &oldest = shard.lru.back();
+        sodium_memzero(oldest.label.data(), oldest.label.size());
+        shard.index.erase(oldest.key);
+        shard.lru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.lru.push_front(Entry{key, vk, label});
+    shard.index.emplace(key, shard.lru.begin());
+}
+
+void LabelCache::Clear()
+{
+    for (size_t i = 0; i < numShards; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        for (auto &entry : shards[i].lru) {
+            sodium_memzero(entry.label.data(), entry.label.size());
+        }
+        shards[i].index.clear();
+        shards[i].lru.clear();
+    }
+}
+
+LabelCacheStats LabelCache::GetStats() const
+{
+    LabelCacheStats stats;
+    stats.hits = hits.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations.load(std::memory_order_relaxed);
+    stats.evictions = evictions.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < numShards; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        stats.size += shards[i].lru.size();
+    }
+    return stats;
+}
+
+} // namespace libjodi
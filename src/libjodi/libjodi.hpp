@@ -3,7 +3,10 @@
 
 #include "includes/base.hpp"
 #include "includes/http.hpp"
+#include "includes/workers.hpp"
 #include "includes/oprf.hpp"
+#include "includes/keystore.hpp"
+#include "includes/labelcache.hpp"
 #include "includes/pairing.hpp"
 #include "includes/voprf.hpp"
 #include "includes/utils.hpp"
@@ -12,11 +15,21 @@
 #include "includes/ciphering.hpp"
 
 namespace libjodi {
+    // Per-stage wall-clock timings of one GenerateCallId call, in microseconds
+    struct CallIdTimings {
+        long blindUs = 0;
+        long fanoutUs = 0;              // first request sent until last reply unblinded
+        vector<long> serverUs;          // round trip plus unblinding, per server
+        long combineUs = 0;
+        long totalUs = 0;
+    };
+
     void panic(string error);
     void print(string message);
     void printlist(vector<uint8_t> message);
     void printBytes(Bytes b);
     vector<uint8_t>GenerateCallId(string callDetails, vector<string> servers);
+    vector<uint8_t>GenerateCallId(const string& callDetails, const vector<string>& servers, CallIdTimings& timings);
     void PublishMessage(vector<uint8_t>callId, vector<uint8_t>msg, vector<uint8_t>gsk);
     void RetrieveMessage(vector<uint8_t>callId, vector<uint8_t>gsk);
 }
@@ -3,6 +3,8 @@
 #include <chrono>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
+#include <iostream>
 #include "libjodi.hpp"  // Your existing .hpp with class definitions
 
 namespace libjodi
@@ -11,26 +13,27 @@ namespace libjodi
 // OPRF IMPLEMENTATIONS
 //------------------------------------------------------------------------------
 
-OPRF_Keypair OPRF::Keygen()
+template <size_t N>
+static std::array<unsigned char, N> toFixed(const Bytes &bytes)
+{
+    std::array<unsigned char, N> out;
+    std::copy(bytes.begin(), bytes.end(), out.begin());
+    return out;
+}
+
+void OPRF::Keygen(OPRF_Scalar &sk, OPRF_Element &pk)
 {
     // Generate random secret scalar sk
-    unsigned char sk[crypto_core_ristretto255_SCALARBYTES];
-    randombytes_buf(sk, sizeof(sk));
+    randombytes_buf(sk.data(), sk.size());
 
     // pk = g^sk
-    unsigned char pk[crypto_core_ristretto255_BYTES];
-    crypto_scalarmult_ristretto255_base(pk, sk);
-
-    OPRF_Keypair keypair;
-    keypair.sk.assign(sk, sk + sizeof(sk));
-    keypair.pk.assign(pk, pk + sizeof(pk));
-    return keypair;
+    crypto_scalarmult_ristretto255_base(pk.data(), sk.data());
 }
 
-OPRF_Blinded OPRF::Blind(const std::string &msg)
+static void hashToGroup(const std::string &msg, unsigned char p_msg[crypto_core_ristretto255_BYTES])
 {
     // 1. Hash message -> 64 bytes
-    unsigned char hashbuf[64];
+    unsigned char hashbuf[crypto_core_ristretto255_HASHBYTES];
     crypto_hash_sha512(
         hashbuf,
         reinterpret_cast<const unsigned char*>(msg.data()),
@@ -38,24 +41,124 @@ OPRF_Blinded OPRF::Blind(const std::string &msg)
     );
 
     // 2. Convert that 64-byte hash to a Ristretto point
-    unsigned char p_msg[crypto_core_ristretto255_BYTES];
     if (crypto_core_ristretto255_from_hash(p_msg, hashbuf) != 0) {
         throw std::runtime_error("crypto_core_ristretto255_from_hash() failed");
     }
+}
+
+static void randomBlindingPair(OPRF_Scalar &r, OPRF_Element &rG)
+{
+    crypto_core_ristretto255_scalar_random(r.data());
+    crypto_scalarmult_ristretto255_base(rG.data(), r.data());
+}
+
+void OPRF::Blind(const std::string &msg, OPRF_Element &x, OPRF_Scalar &r)
+{
+    unsigned char p_msg[crypto_core_ristretto255_BYTES];
+    hashToGroup(msg, p_msg);
 
     // 3. rand_scalar -> rand_point -> x = p_msg + rand_point
-    unsigned char rand_scalar[crypto_core_ristretto255_SCALARBYTES];
-    unsigned char rand_point[crypto_core_ristretto255_BYTES];
-    unsigned char x[crypto_core_ristretto255_BYTES];
+    OPRF_Element rand_point;
+    randomBlindingPair(r, rand_point);
+    crypto_core_ristretto255_add(x.data(), p_msg, rand_point.data());
+}
 
-    crypto_core_ristretto255_scalar_random(rand_scalar);
-    crypto_scalarmult_ristretto255_base(rand_point, rand_scalar);
-    crypto_core_ristretto255_add(x, p_msg, rand_point);
+void OPRF::Blind(const std::string &msg, OPRF_BlindingPool &pool, OPRF_Element &x, OPRF_Scalar &r)
+{
+    unsigned char p_msg[crypto_core_ristretto255_BYTES];
+    hashToGroup(msg, p_msg);
 
-    OPRF_Blinded out;
-    out.x.assign(x, x + sizeof(x));
-    out.r.assign(rand_scalar, rand_scalar + sizeof(rand_scalar));
-    return out;
+    // The (r, g^r) pair comes precomputed, leaving one point addition
+    OPRF_Element rand_point;
+    pool.Take(r, rand_point);
+    crypto_core_ristretto255_add(x.data(), p_msg, rand_point.data());
+}
+
+void OPRF::Evaluate(const OPRF_Scalar &sk, const OPRF_Element &x, OPRF_Element &fx)
+{
+    if (crypto_scalarmult_ristretto255(fx.data(), sk.data(), x.data()) != 0) {
+        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in Evaluate()");
+    }
+}
+
+void OPRF::Unblind(const OPRF_Element &fx, const OPRF_Element &vk, const OPRF_Scalar &r, OPRF_Element &out)
+{
+    // pk_r = pk^r
+    unsigned char pk_r[crypto_core_ristretto255_BYTES];
+    if (crypto_scalarmult_ristretto255(pk_r, r.data(), vk.data()) != 0) {
+        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in Unblind()");
+    }
+
+    // out = fx - pk_r
+    crypto_core_ristretto255_sub(out.data(), fx.data(), pk_r);
+}
+
+void OPRF::Unblind(const OPRF_Element &fx, const PreparedOprfPublicKey &vk, const OPRF_Scalar &r, OPRF_Element &out)
+{
+    // The key was validated when it was prepared
+    Unblind(fx, vk.GetElement(), r, out);
+}
+
+static const char KEYRING_KDF_DST[] = "JODI-OPRF-KeyRing-v1";
+
+void OPRF::DeriveKeypair(const Bytes &masterSeed, uint64_t generation, uint32_t index, OPRF_Scalar &sk, OPRF_Element &pk)
+{
+    if (masterSeed.size() < crypto_generichash_KEYBYTES_MIN ||
+        masterSeed.size() > crypto_generichash_KEYBYTES_MAX) {
+        throw std::invalid_argument("OPRF::DeriveKeypair: invalid master seed size");
+    }
+
+    // input = DST || generation (LE64) || index (LE32)
+    unsigned char input[sizeof(KEYRING_KDF_DST) - 1 + 12];
+    std::copy(KEYRING_KDF_DST, KEYRING_KDF_DST + sizeof(KEYRING_KDF_DST) - 1, input);
+    unsigned char *p = input + sizeof(KEYRING_KDF_DST) - 1;
+    for (int b = 0; b < 8; ++b) *p++ = (unsigned char)(generation >> (8 * b));
+    for (int b = 0; b < 4; ++b) *p++ = (unsigned char)(index >> (8 * b));
+
+    unsigned char wide[crypto_core_ristretto255_NONREDUCEDSCALARBYTES];
+    crypto_generichash(wide, sizeof(wide), input, sizeof(input), masterSeed.data(), masterSeed.size());
+    crypto_core_ristretto255_scalar_reduce(sk.data(), wide);
+    sodium_memzero(wide, sizeof(wide));
+
+    // pk = g^sk
+    if (crypto_scalarmult_ristretto255_base(pk.data(), sk.data()) != 0) {
+        throw std::runtime_error("OPRF::DeriveKeypair: derived a zero key");
+    }
+}
+
+OPRF_Keypair OPRF::DeriveKeypair(const Bytes &masterSeed, uint64_t generation, uint32_t index)
+{
+    OPRF_Scalar sk;
+    OPRF_Element pk;
+    DeriveKeypair(masterSeed, generation, index, sk, pk);
+
+    OPRF_Keypair keypair(Bytes(sk.begin(), sk.end()), Bytes(pk.begin(), pk.end()));
+    sodium_memzero(sk.data(), sk.size());
+    return keypair;
+}
+
+OPRF_Keypair OPRF::Keygen()
+{
+    OPRF_Scalar sk;
+    OPRF_Element pk;
+    Keygen(sk, pk);
+    return OPRF_Keypair(Bytes(sk.begin(), sk.end()), Bytes(pk.begin(), pk.end()));
+}
+
+OPRF_Blinded OPRF::Blind(const std::string &msg)
+{
+    OPRF_Element x;
+    OPRF_Scalar r;
+    Blind(msg, x, r);
+    return OPRF_Blinded(Bytes(x.begin(), x.end()), Bytes(r.begin(), r.end()));
+}
+
+OPRF_Blinded OPRF::Blind(const std::string &msg, OPRF_BlindingPool &pool)
+{
+    OPRF_Element x;
+    OPRF_Scalar r;
+    Blind(msg, pool, x, r);
+    return OPRF_Blinded(Bytes(x.begin(), x.end()), Bytes(r.begin(), r.end()));
 }
 
 OPRF_BlindedEval OPRF::Evaluate(const OPRF_Keypair &keypair, const Bytes &x)
@@ -63,120 +166,831 @@ OPRF_BlindedEval OPRF::Evaluate(const OPRF_Keypair &keypair, const Bytes &x)
     if (x.size() != crypto_core_ristretto255_BYTES) {
         throw std::runtime_error("OPRF::Evaluate: invalid x size");
     }
+    if (keypair.sk.size() != crypto_core_ristretto255_SCALARBYTES) {
+        throw std::runtime_error("OPRF::Evaluate: invalid sk size");
+    }
+
+    OPRF_Element fx;
+    Evaluate(toFixed<crypto_core_ristretto255_SCALARBYTES>(keypair.sk),
+             toFixed<crypto_core_ristretto255_BYTES>(x), fx);
+
+    // store pubkey as verification key
+    return OPRF_BlindedEval(Bytes(fx.begin(), fx.end()), keypair.pk);
+}
+
+// Smallest slice of a batch worth handing to another worker
+static const size_t EVALUATE_BATCH_MIN_CHUNK = 8;
+
+template <typename XAt>
+static OPRF_BatchEval evaluateBatch(const OPRF_Keypair &keypair, size_t count, XAt xAt, WorkerPool &pool)
+{
+    // Decode and validate the key once for the whole batch
+    if (keypair.sk.size() != crypto_core_ristretto255_SCALARBYTES ||
+        keypair.pk.size() != crypto_core_ristretto255_BYTES) {
+        throw std::runtime_error("OPRF::EvaluateBatch: invalid keypair size");
+    }
+    if (sodium_is_zero(keypair.sk.data(), keypair.sk.size()) ||
+        crypto_core_ristretto255_is_valid_point(keypair.pk.data()) != 1) {
+        throw std::runtime_error("OPRF::EvaluateBatch: invalid keypair");
+    }
+
+    OPRF_BatchEval out;
+    out.fx.resize(count * crypto_core_ristretto255_BYTES);
+    out.vk = keypair.pk;
 
     const unsigned char* skchar = keypair.sk.data();
-    const unsigned char* xchar  = x.data();
+    unsigned char* fxchar = out.fx.data();
 
-    unsigned char fx[crypto_core_ristretto255_BYTES];
-    if (crypto_scalarmult_ristretto255(fx, skchar, xchar) != 0) {
-        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in Evaluate()");
+    pool.ParallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (crypto_scalarmult_ristretto255(fxchar + i * crypto_core_ristretto255_BYTES, skchar, xAt(i)) != 0) {
+                throw std::runtime_error("crypto_scalarmult_ristretto255() failed in EvaluateBatch() at index " + std::to_string(i));
+            }
+        }
+    }, EVALUATE_BATCH_MIN_CHUNK);
+
+    return out;
+}
+
+OPRF_BatchEval OPRF::EvaluateBatch(const OPRF_Keypair &keypair, const vector<Bytes> &xs, WorkerPool &pool)
+{
+    for (const auto &x : xs) {
+        if (x.size() != crypto_core_ristretto255_BYTES) {
+            throw std::runtime_error("OPRF::EvaluateBatch: invalid x size");
+        }
     }
 
-    OPRF_BlindedEval out;
-    out.fx.assign(fx, fx + sizeof(fx));
-    out.vk = keypair.pk;  // store pubkey as verification key
+    return evaluateBatch(keypair, xs.size(), [&xs](size_t i) {
+        return xs[i].data();
+    }, pool);
+}
+
+OPRF_BatchEval OPRF::EvaluateBatch(const OPRF_Keypair &keypair, const unsigned char *xs, size_t count, WorkerPool &pool)
+{
+    if (xs == nullptr && count > 0) {
+        throw std::runtime_error("OPRF::EvaluateBatch: null input");
+    }
+
+    return evaluateBatch(keypair, count, [xs](size_t i) {
+        return xs + i * crypto_core_ristretto255_BYTES;
+    }, pool);
+}
+
+OPRF_BatchEval OPRF::EvaluateBatch(const OPRF_Keypair &keypair, const vector<Bytes> &xs, OPRF_Proof &proof, WorkerPool &pool)
+{
+    OPRF_BatchEval eval = EvaluateBatch(keypair, xs, pool);
+    proof = ProveBatch(keypair, xs, eval, pool);
+    return eval;
+}
+
+//------------------------------------------------------------------------------
+// DLEQ PROOF IMPLEMENTATIONS
+//------------------------------------------------------------------------------
+
+static const char DLEQ_SEED_DST[] = "JODI-OPRF-DLEQ-v1-Seed";
+static const char DLEQ_COMPOSITE_DST[] = "JODI-OPRF-DLEQ-v1-Composite";
+static const char DLEQ_CHALLENGE_DST[] = "JODI-OPRF-DLEQ-v1-Challenge";
+
+static void hashDst(crypto_hash_sha512_state &state, const char *dst, size_t len)
+{
+    crypto_hash_sha512_update(&state, reinterpret_cast<const unsigned char*>(dst), len);
+}
+
+static void hashIndex(crypto_hash_sha512_state &state, uint64_t i)
+{
+    unsigned char le[8];
+    for (int b = 0; b < 8; ++b) le[b] = (unsigned char)(i >> (8 * b));
+    crypto_hash_sha512_update(&state, le, sizeof(le));
+}
+
+static void hashToScalar(crypto_hash_sha512_state &state, OPRF_Scalar &out)
+{
+    unsigned char wide[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512_final(&state, wide);
+    crypto_core_ristretto255_scalar_reduce(out.data(), wide);
+}
+
+// The scalar crypto_scalarmult_ristretto255 really applies: top bit cleared, mod L
+static void effectiveScalar(const unsigned char *sk, OPRF_Scalar &out)
+{
+    unsigned char wide[crypto_core_ristretto255_NONREDUCEDSCALARBYTES] = {0};
+    std::copy(sk, sk + crypto_core_ristretto255_SCALARBYTES, wide);
+    wide[31] &= 127;
+    crypto_core_ristretto255_scalar_reduce(out.data(), wide);
+    sodium_memzero(wide, sizeof(wide));
+}
+
+static void accumulate(OPRF_Element &sum, const unsigned char *p, bool &have)
+{
+    if (have) {
+        crypto_core_ristretto255_add(sum.data(), sum.data(), p);
+    } else {
+        std::copy(p, p + crypto_core_ristretto255_BYTES, sum.begin());
+        have = true;
+    }
+}
+
+static bool checkBatchShape(const vector<Bytes> &xs, const OPRF_BatchEval &eval)
+{
+    if (xs.empty() || eval.Size() != xs.size() ||
+        eval.fx.size() != xs.size() * crypto_core_ristretto255_BYTES) {
+        return false;
+    }
+    for (const auto &x : xs) {
+        if (x.size() != crypto_core_ristretto255_BYTES) return false;
+    }
+    return true;
+}
+
+// M = sum(d_i * x_i) and, if withZ, Z = sum(d_i * fx_i), where the d_i are
+// derived from a hash of the whole batch. Returns false on invalid points.
+static bool computeComposites(const Bytes &vk, const vector<Bytes> &xs, const OPRF_BatchEval &eval,
+                              bool withZ, OPRF_Element &M, OPRF_Element &Z, WorkerPool &pool)
+{
+    unsigned char seed[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512_state state;
+    crypto_hash_sha512_init(&state);
+    hashDst(state, DLEQ_SEED_DST, sizeof(DLEQ_SEED_DST) - 1);
+    crypto_hash_sha512_update(&state, vk.data(), vk.size());
+    hashIndex(state, xs.size());
+    for (const auto &x : xs) {
+        crypto_hash_sha512_update(&state, x.data(), x.size());
+    }
+    crypto_hash_sha512_update(&state, eval.fx.data(), eval.fx.size());
+    crypto_hash_sha512_final(&state, seed);
+
+    std::mutex sumMutex;
+    std::atomic<bool> failed{false};
+    bool haveM = false, haveZ = false;
+
+    pool.ParallelFor(xs.size(), [&](size_t begin, size_t end) {
+        OPRF_Element m, z;
+        bool have_m = false, have_z = false;
+        unsigned char term[crypto_core_ristretto255_BYTES];
+
+        for (size_t i = begin; i < end && !failed; ++i) {
+            OPRF_Scalar d;
+            crypto_hash_sha512_state ds;
+            crypto_hash_sha512_init(&ds);
+            hashDst(ds, DLEQ_COMPOSITE_DST, sizeof(DLEQ_COMPOSITE_DST) - 1);
+            crypto_hash_sha512_update(&ds, seed, sizeof(seed));
+            hashIndex(ds, i);
+            hashToScalar(ds, d);
+
+            if (crypto_scalarmult_ristretto255(term, d.data(), xs[i].data()) != 0) {
+                failed = true;
+                break;
+            }
+            accumulate(m, term, have_m);
+
+            if (withZ) {
+                const unsigned char *fx = eval.fx.data() + i * crypto_core_ristretto255_BYTES;
+                if (crypto_scalarmult_ristretto255(term, d.data(), fx) != 0) {
+                    failed = true;
+                    break;
+                }
+                accumulate(z, term, have_z);
+            }
+        }
+
+        if (failed) return;
+        std::lock_guard<std::mutex> lock(sumMutex);
+        accumulate(M, m.data(), haveM);
+        if (withZ) accumulate(Z, z.data(), haveZ);
+    }, EVALUATE_BATCH_MIN_CHUNK);
+
+    return !failed;
+}
+
+static void challenge(const Bytes &vk, const OPRF_Element &M, const OPRF_Element &Z,
+                      const unsigned char *A, const unsigned char *B, OPRF_Scalar &c)
+{
+    crypto_hash_sha512_state state;
+    crypto_hash_sha512_init(&state);
+    hashDst(state, DLEQ_CHALLENGE_DST, sizeof(DLEQ_CHALLENGE_DST) - 1);
+    crypto_hash_sha512_update(&state, vk.data(), vk.size());
+    crypto_hash_sha512_update(&state, M.data(), M.size());
+    crypto_hash_sha512_update(&state, Z.data(), Z.size());
+    crypto_hash_sha512_update(&state, A, crypto_core_ristretto255_BYTES);
+    crypto_hash_sha512_update(&state, B, crypto_core_ristretto255_BYTES);
+    hashToScalar(state, c);
+}
+
+Bytes OPRF_Proof::ToBytes() const
+{
+    Bytes out(c.begin(), c.end());
+    out.insert(out.end(), s.begin(), s.end());
     return out;
 }
 
-Bytes OPRF::Unblind(OPRF_BlindedEval eval, Bytes &sk)
+OPRF_Proof OPRF_Proof::FromBytes(const Bytes &bytes)
+{
+    if (bytes.size() != SIZE) {
+        throw std::runtime_error("OPRF_Proof::FromBytes: invalid proof size");
+    }
+
+    OPRF_Proof proof;
+    std::copy(bytes.begin(), bytes.begin() + proof.c.size(), proof.c.begin());
+    std::copy(bytes.begin() + proof.c.size(), bytes.end(), proof.s.begin());
+    return proof;
+}
+
+OPRF_Proof OPRF::ProveBatch(const OPRF_Keypair &keypair, const vector<Bytes> &xs, const OPRF_BatchEval &eval, WorkerPool &pool)
+{
+    if (keypair.sk.size() != crypto_core_ristretto255_SCALARBYTES ||
+        keypair.pk.size() != crypto_core_ristretto255_BYTES) {
+        throw std::runtime_error("OPRF::ProveBatch: invalid keypair size");
+    }
+    if (!checkBatchShape(xs, eval)) {
+        throw std::runtime_error("OPRF::ProveBatch: invalid batch");
+    }
+
+    OPRF_Element M, Z;
+    if (!computeComposites(keypair.pk, xs, eval, false, M, Z, pool)) {
+        throw std::runtime_error("OPRF::ProveBatch: invalid blinded element");
+    }
+
+    // The prover knows k, so Z = k * M saves a second pass over the batch
+    OPRF_Scalar k, t, c, ck;
+    effectiveScalar(keypair.sk.data(), k);
+
+    unsigned char A[crypto_core_ristretto255_BYTES];
+    unsigned char B[crypto_core_ristretto255_BYTES];
+
+    if (crypto_scalarmult_ristretto255(Z.data(), k.data(), M.data()) != 0) {
+        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in ProveBatch()");
+    }
+
+    crypto_core_ristretto255_scalar_random(t.data());
+    crypto_scalarmult_ristretto255_base(A, t.data());
+    if (crypto_scalarmult_ristretto255(B, t.data(), M.data()) != 0) {
+        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in ProveBatch()");
+    }
+
+    challenge(keypair.pk, M, Z, A, B, c);
+
+    // s = t - c * k
+    OPRF_Proof proof;
+    proof.c = c;
+    crypto_core_ristretto255_scalar_mul(ck.data(), c.data(), k.data());
+    crypto_core_ristretto255_scalar_sub(proof.s.data(), t.data(), ck.data());
+
+    sodium_memzero(k.data(), k.size());
+    sodium_memzero(t.data(), t.size());
+    sodium_memzero(ck.data(), ck.size());
+    return proof;
+}
+
+bool OPRF::VerifyBatch(const Bytes &vk, const vector<Bytes> &xs, const OPRF_BatchEval &eval, const OPRF_Proof &proof, WorkerPool &pool)
+{
+    if (vk.size() != crypto_core_ristretto255_BYTES ||
+        crypto_core_ristretto255_is_valid_point(vk.data()) != 1 ||
+        !checkBatchShape(xs, eval)) {
+        return false;
+    }
+
+    OPRF_Element M, Z;
+    if (!computeComposites(vk, xs, eval, true, M, Z, pool)) {
+        return false;
+    }
+
+    // A = s*G + c*vk, B = s*M + c*Z
+    unsigned char sP[crypto_core_ristretto255_BYTES];
+    unsigned char cP[crypto_core_ristretto255_BYTES];
+    unsigned char A[crypto_core_ristretto255_BYTES];
+    unsigned char B[crypto_core_ristretto255_BYTES];
+
+    if (crypto_scalarmult_ristretto255_base(sP, proof.s.data()) != 0 ||
+        crypto_scalarmult_ristretto255(cP, proof.c.data(), vk.data()) != 0) {
+        return false;
+    }
+    crypto_core_ristretto255_add(A, sP, cP);
+
+    if (crypto_scalarmult_ristretto255(sP, proof.s.data(), M.data()) != 0 ||
+        crypto_scalarmult_ristretto255(cP, proof.c.data(), Z.data()) != 0) {
+        return false;
+    }
+    crypto_core_ristretto255_add(B, sP, cP);
+
+    OPRF_Scalar c;
+    challenge(vk, M, Z, A, B, c);
+    return sodium_memcmp(c.data(), proof.c.data(), c.size()) == 0;
+}
+
+Bytes OPRF::Unblind(const OPRF_BlindedEval &eval, const Bytes &r)
 {
-    // Optional: check sizes
     if (eval.vk.size() != crypto_core_ristretto255_BYTES ||
         eval.fx.size() != crypto_core_ristretto255_BYTES ||
-        sk.size()       != crypto_core_ristretto255_SCALARBYTES)
+        r.size()       != crypto_core_ristretto255_SCALARBYTES)
     {
         throw std::runtime_error("OPRF::Unblind: invalid input size");
     }
 
-    const unsigned char* skchar = sk.data();
-    const unsigned char* pkchar = eval.vk.data();
-    const unsigned char* fxchar = eval.fx.data();
+    OPRF_Element out;
+    Unblind(toFixed<crypto_core_ristretto255_BYTES>(eval.fx),
+            toFixed<crypto_core_ristretto255_BYTES>(eval.vk),
+            toFixed<crypto_core_ristretto255_SCALARBYTES>(r), out);
 
-    // negative scalar
-    unsigned char neg_sk[crypto_core_ristretto255_SCALARBYTES];
-    crypto_core_ristretto255_scalar_negate(neg_sk, skchar);
+    return Bytes(out.begin(), out.end());
+}
 
-    // pk_neg_sk = pk^(neg_sk)
-    unsigned char pk_neg_sk[crypto_core_ristretto255_BYTES];
-    if (crypto_scalarmult_ristretto255(pk_neg_sk, neg_sk, pkchar) != 0) {
-        throw std::runtime_error("crypto_scalarmult_ristretto255() failed in Unblind()");
+Bytes OPRF::Unblind(const OPRF_BlindedEval &eval, const OPRF_Blinded &blinding)
+{
+    return Unblind(eval, blinding.r);
+}
+
+PreparedOprfPublicKey::PreparedOprfPublicKey(const Bytes &pk)
+{
+    if (pk.size() != crypto_core_ristretto255_BYTES ||
+        crypto_core_ristretto255_is_valid_point(pk.data()) != 1) {
+        throw std::runtime_error("PreparedOprfPublicKey: invalid public key");
+    }
+
+    std::copy(pk.begin(), pk.end(), vk.begin());
+    valid = true;
+}
+
+bool PreparedOprfPublicKey::Matches(const Bytes &other) const
+{
+    return valid &&
+           other.size() == crypto_core_ristretto255_BYTES &&
+           sodium_memcmp(vk.data(), other.data(), vk.size()) == 0;
+}
+
+Bytes OPRF::Unblind(const OPRF_BlindedEval &eval, const PreparedOprfPublicKey &vk, const Bytes &r)
+{
+    if (eval.fx.size() != crypto_core_ristretto255_BYTES ||
+        r.size()       != crypto_core_ristretto255_SCALARBYTES)
+    {
+        throw std::runtime_error("OPRF::Unblind: invalid input size");
+    }
+
+    // Only make sure the evaluation was produced under the prepared key
+    if (!eval.vk.empty() && !vk.Matches(eval.vk)) {
+        throw std::runtime_error("OPRF::Unblind: evaluation does not match prepared key");
+    }
+
+    OPRF_Element out;
+    Unblind(toFixed<crypto_core_ristretto255_BYTES>(eval.fx), vk,
+            toFixed<crypto_core_ristretto255_SCALARBYTES>(r), out);
+
+    return Bytes(out.begin(), out.end());
+}
+
+//------------------------------------------------------------------------------
+// BLINDING POOL IMPLEMENTATIONS
+//------------------------------------------------------------------------------
+
+// Upper bound on how long a missed wakeup can leave the producer idle
+static const auto BLINDING_POOL_POLL = std::chrono::milliseconds(50);
+
+OPRF_BlindingPool::OPRF_BlindingPool(size_t capacity, size_t lowWatermark, size_t highWatermark)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("OPRF_BlindingPool: capacity must be positive");
+    }
+
+    // Round up to a power of two so slot positions can be masked
+    this->capacity = 1;
+    while (this->capacity < capacity) this->capacity <<= 1;
+
+    this->highWatermark = highWatermark == 0 ? this->capacity : highWatermark;
+    this->lowWatermark = lowWatermark;
+
+    if (this->highWatermark > this->capacity || this->lowWatermark >= this->highWatermark) {
+        throw std::invalid_argument("OPRF_BlindingPool: need lowWatermark < highWatermark <= capacity");
+    }
+
+    slots.reset(new Slot[this->capacity]);
+    for (size_t i = 0; i < this->capacity; ++i) {
+        slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+OPRF_BlindingPool::~OPRF_BlindingPool()
+{
+    Stop();
+
+    for (size_t i = 0; i < capacity; ++i) {
+        sodium_memzero(slots[i].r.data(), slots[i].r.size());
+    }
+}
+
+void OPRF_BlindingPool::Start()
+{
+    if (running.exchange(true)) return;
+
+    producer = std::thread([this]() {
+        while (running) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCv.wait_for(lock, BLINDING_POOL_POLL, [this]() {
+                    return !running || Available() <= lowWatermark;
+                });
+            }
+            if (!running) break;
+            if (Available() > lowWatermark) continue;
+
+            refills.fetch_add(1, std::memory_order_relaxed);
+
+            OPRF_Scalar r;
+            OPRF_Element rG;
+            while (running && Available() < highWatermark) {
+                randomBlindingPair(r, rG);
+                if (!TryPush(r, rG)) break;
+                produced.fetch_add(1, std::memory_order_relaxed);
+            }
+            sodium_memzero(r.data(), r.size());
+            refillRequested = false;
+        }
+    });
+}
+
+void OPRF_BlindingPool::Stop()
+{
+    if (!running.exchange(false)) return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
     }
+    wakeCv.notify_all();
 
-    // out = fx + pk_neg_sk
-    unsigned char out[crypto_core_ristretto255_BYTES];
-    crypto_core_ristretto255_add(out, fxchar, pk_neg_sk);
+    if (producer.joinable()) {
+        producer.join();
+    }
+}
 
-    return Bytes(out, out + sizeof(out));
+size_t OPRF_BlindingPool::Available() const
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_relaxed);
+    return t > h ? t - h : 0;
+}
+
+// Bounded MPMC queue after Vyukov: each slot's sequence number says whether
+// it is free for the writer at position pos (seq == pos) or holds data for the
+// reader at pos (seq == pos + 1).
+bool OPRF_BlindingPool::TryPush(const OPRF_Scalar &r, const OPRF_Element &rG)
+{
+    size_t pos = tail.load(std::memory_order_relaxed);
+    Slot *slot;
+
+    while (true) {
+        slot = &slots[pos & (capacity - 1)];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->r = r;
+    slot->rG = rG;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool OPRF_BlindingPool::TryTake(OPRF_Scalar &r, OPRF_Element &rG)
+{
+    size_t pos = head.load(std::memory_order_relaxed);
+    Slot *slot;
+
+    while (true) {
+        slot = &slots[pos & (capacity - 1)];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // empty
+        } else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    r = slot->r;
+    rG = slot->rG;
+    sodium_memzero(slot->r.data(), slot->r.size());
+    slot->seq.store(pos + capacity, std::memory_order_release);
+
+    consumed.fetch_add(1, std::memory_order_relaxed);
+
+    // Wake the producer once per refill cycle; it also polls, so a wakeup
+    // lost to the race with its predicate check only delays the refill.
+    if (running && Available() <= lowWatermark && !refillRequested.exchange(true)) {
+        wakeCv.notify_one();
+    }
+    return true;
+}
+
+void OPRF_BlindingPool::Take(OPRF_Scalar &r, OPRF_Element &rG)
+{
+    if (TryTake(r, rG)) return;
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    randomBlindingPair(r, rG);
+}
+
+OPRF_BlindingPoolStats OPRF_BlindingPool::GetStats() const
+{
+    OPRF_BlindingPoolStats stats;
+    stats.produced = produced.load(std::memory_order_relaxed);
+    stats.consumed = consumed.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.refills = refills.load(std::memory_order_relaxed);
+    stats.available = Available();
+    return stats;
 }
 
 //------------------------------------------------------------------------------
 // KEYROTATION IMPLEMENTATIONS
 //------------------------------------------------------------------------------
 
+KeyRing::~KeyRing()
+{
+    sodium_memzero(recentlyExpiredKey.sk.data(), recentlyExpiredKey.sk.size());
+    for (auto &key : keys) {
+        sodium_memzero(key.sk.data(), key.sk.size());
+    }
+}
+
+bool KeyRing::IsExpiredWithin(int index, int tmax) const
+{
+    if (index < 0 || index >= (int)keys.size()) {
+        throw std::out_of_range("KeyRotation::IsExpiredWithin index out of range");
+    }
+
+    if (index != recentlyExpiredIndex) return false;
+
+    auto currentTime = std::chrono::system_clock::now();
+    auto thresholdTime = currentTime - std::chrono::seconds(tmax);
+
+    return (recentlyExpiredTime >= thresholdTime);
+}
+
+const OPRF_Keypair& KeyRing::GetKey(int index) const
+{
+    if (index < 0 || index >= (int)keys.size()) {
+        throw std::out_of_range("KeyRotation::GetKey index out of range");
+    }
+    return keys[index];
+}
+
+KeyRingSnapshot KeyRotation::GetSnapshot() const
+{
+    // Each thread remembers the last ring it saw, weakly so that a retired
+    // ring (and its secret keys) is freed as soon as no caller holds it.
+    // The published pointer is only reloaded when ringVersion moves.
+    struct Cached {
+        const KeyRotation* owner = nullptr;
+        uint64_t version = 0;
+        std::weak_ptr<const KeyRing> ring;
+    };
+    thread_local Cached cached;
+
+    uint64_t version = ringVersion.load(std::memory_order_acquire);
+    if (cached.owner == this && cached.version == version) {
+        if (auto snapshot = cached.ring.lock()) return snapshot;
+    }
+
+    KeyRingSnapshot snapshot = std::atomic_load(&ring);
+    cached.ring = snapshot;
+    cached.version = version;
+    cached.owner = this;
+    return snapshot;
+}
+
+void KeyRotation::Publish(std::shared_ptr<const KeyRing> next)
+{
+    std::atomic_store(&ring, std::move(next));
+    ringVersion.fetch_add(1, std::memory_order_release);
+}
+
+void KeyRotation::Persist(const KeyRing &next)
+{
+    if (!store) return;
+    try {
+        store->Save(next);
+    } catch (const std::exception &e) {
+        // Keep rotating; the next tick retries the write
+        std::cerr << "[KeyRotation] " << e.what() << "\n";
+    }
+}
+
+bool KeyRotation::WaitUntil(std::chrono::system_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    return !wakeCv.wait_until(lock, deadline, [this]() { return stopRotation.load(); });
+}
+
+void KeyRotation::UseKeyStore(const std::string &path)
+{
+    std::lock_guard<std::mutex> control(controlMutex);
+    store = path.empty() ? nullptr : std::make_shared<KeyStore>(path);
+}
+
+// One random rotation tick: replace the next slot and remember the old key
+static void rotateRandom(KeyRing &ring, std::chrono::system_clock::time_point when)
+{
+    ring.epoch++;
+    ring.expiryIndex = (ring.expiryIndex + 1) % ring.keys.size();
+    ring.recentlyExpiredIndex = ring.expiryIndex;
+    ring.recentlyExpiredKey = ring.keys[ring.recentlyExpiredIndex];
+    ring.keys[ring.expiryIndex] = OPRF::Keygen();
+    ring.recentlyExpiredTime = when;
+    ring.rotationTime = when;
+}
+
 void KeyRotation::StartRotation(int size, int interval) {
+        std::lock_guard<std::mutex> control(controlMutex);
         if (rotationRunning) return;
 
-        expiryIndex = -1;
-        recentlyExpiredIndex = -1;
-        keyList.clear();
+        if (size <= 0 || interval <= 0) {
+            throw std::invalid_argument("KeyRotation::StartRotation: size and interval must be positive");
+        }
 
-        for (auto i = 0; i < size; ++i) {
-            keyList.push_back(OPRF::Keygen());
+        auto now = std::chrono::system_clock::now();
+        std::shared_ptr<KeyRing> initial;
+
+        if (store) {
+            auto loaded = store->Load();
+            if (loaded && (int)loaded->keys.size() == size) {
+                initial = std::make_shared<KeyRing>(*loaded);
+
+                // Apply the ticks missed while the process was down. Only the
+                // last size of them can change a key.
+                auto step = std::chrono::seconds(interval);
+                uint64_t missed = now > initial->rotationTime ? (now - initial->rotationTime) / step : 0;
+                uint64_t skipped = missed > (uint64_t)size ? missed - size : 0;
+                if (skipped > 0) {
+                    initial->epoch += skipped;
+                    initial->expiryIndex = (int)((initial->expiryIndex + skipped) % size);
+                    initial->rotationTime += skipped * step;
+                }
+                for (uint64_t t = skipped; t < missed; ++t) {
+                    rotateRandom(*initial, initial->rotationTime + step);
+                }
+            }
         }
 
-        rotationRunning = true;
-        stopRotation = false;
+        if (!initial) {
+            initial = std::make_shared<KeyRing>();
+            for (auto i = 0; i < size; ++i) {
+                initial->keys.push_back(OPRF::Keygen());
+            }
+            initial->rotationTime = now;
+        }
 
-        std::thread([this, interval]() {
-            while (!stopRotation) {
-                std::this_thread::sleep_for(std::chrono::seconds(interval));
+        {
+            std::lock_guard<std::mutex> lock(sharedMutex);
+            Publish(initial);
+        }
+        Persist(*initial);
 
-                if (stopRotation) break;
+        rotationRunning = true;
+        stopRotation = false;
 
+        rotationThread = std::thread([this, interval]() {
+            while (WaitUntil(GetSnapshot()->rotationTime + std::chrono::seconds(interval))) {
                 std::lock_guard<std::mutex> lock(sharedMutex);
-                //set current expiry index
-                expiryIndex = (expiryIndex + 1) % keyList.size();
-                // let current exppiryIndex be the recently expired
-                recentlyExpiredIndex = expiryIndex;
-                // let's keep the recently expired key
-                recentlyExpiredKey = keyList[recentlyExpiredIndex];
-                // let's replace the expired key
-                keyList[expiryIndex] = OPRF::Keygen();
-                // Remember the time recentlyExpiredIndex was replaced
-                recentlyExpiredTime = std::chrono::system_clock::now();
+                auto next = std::make_shared<KeyRing>(*std::atomic_load(&ring));
+                rotateRandom(*next, std::chrono::system_clock::now());
+                Publish(next);
+                Persist(*next);
             }
-
-            rotationRunning = false;
-        }).detach();
+        });
     }
 
     void KeyRotation::StopRotation() {
+        std::lock_guard<std::mutex> control(controlMutex);
         if (!rotationRunning) return;
 
-        stopRotation = true; // Signal the thread to stop
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopRotation = true; // Signal the thread to stop
+        }
+        wakeCv.notify_all();
+        if (rotationThread.joinable()) rotationThread.join();
+        rotationRunning = false;
+
+        // Cleanup state; the key store keeps the last ring for the next start
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        Publish(std::make_shared<KeyRing>());
+    }
 
-        // Wait briefly to ensure the thread finishes (optional, based on your use case)
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+// How many times slot index has been replaced after tick rotation ticks;
+// tick t (1-based) replaces slot (t - 1) % size.
+static uint64_t slotGeneration(uint64_t tick, int size, int index)
+{
+    if (tick <= (uint64_t)index) return 0;
+    return (tick - 1 - index) / size + 1;
+}
 
-        // Cleanup state
-        expiryIndex = -1;
-        keyList.clear();
+uint64_t KeyRotation::CurrentTick(int interval, int64_t genesis)
+{
+    if (interval <= 0) {
+        throw std::invalid_argument("KeyRotation::CurrentTick: interval must be positive");
     }
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (now <= genesis) return 0;
+    return (uint64_t)((now - genesis) / interval);
+}
 
-bool KeyRotation::IsExpiredWithin(int index, int tmax)
+OPRF_Keypair KeyRotation::DeriveKey(const Bytes &masterSeed, int size, uint64_t tick, int index)
 {
-    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (size <= 0 || index < 0 || index >= size) {
+        throw std::out_of_range("KeyRotation::DeriveKey index out of range");
+    }
+    return OPRF::DeriveKeypair(masterSeed, slotGeneration(tick, size, index), index);
+}
 
-    if (index < 0 || index >= (int)keyList.size()) {
-        throw std::out_of_range("KeyRotation::IsExpiredWithin index out of range");
+KeyRingSnapshot KeyRotation::DeriveRing(const Bytes &masterSeed, int size, int interval, int64_t genesis, uint64_t tick)
+{
+    if (size <= 0 || interval <= 0) {
+        throw std::invalid_argument("KeyRotation::DeriveRing: size and interval must be positive");
     }
 
-    if (index != recentlyExpiredIndex) return false;
+    auto next = std::make_shared<KeyRing>();
+    next->epoch = tick;
+    next->keys.resize(size);
+    next->rotationTime = std::chrono::system_clock::time_point(
+        std::chrono::seconds(genesis + (int64_t)tick * interval));
 
-    auto currentTime = std::chrono::system_clock::now();
-    auto thresholdTime = currentTime - std::chrono::seconds(tmax);
+    WorkerPool::GetDefault().ParallelFor(size, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            next->keys[i] = DeriveKey(masterSeed, size, tick, (int)i);
+        }
+    });
+
+    if (tick > 0) {
+        int expired = (int)((tick - 1) % size);
+        next->expiryIndex = expired;
+        next->recentlyExpiredIndex = expired;
+        next->recentlyExpiredKey = OPRF::DeriveKeypair(masterSeed, slotGeneration(tick, size, expired) - 1, expired);
+        next->recentlyExpiredTime = next->rotationTime;
+    }
 
-    return (recentlyExpiredTime >= thresholdTime);
+    return next;
+}
+
+void KeyRotation::StartRotation(int size, int interval, const Bytes &masterSeed, int64_t genesis)
+{
+    std::lock_guard<std::mutex> control(controlMutex);
+    if (rotationRunning) return;
+
+    if (size <= 0 || interval <= 0) {
+        throw std::invalid_argument("KeyRotation::StartRotation: size and interval must be positive");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        Publish(DeriveRing(masterSeed, size, interval, genesis, CurrentTick(interval, genesis)));
+    }
+
+    rotationRunning = true;
+    stopRotation = false;
+
+    rotationThread = std::thread([this, size, interval, genesis, seed = masterSeed]() mutable {
+        // Ticks fall on genesis + k * interval for every replica
+        while (WaitUntil(GetSnapshot()->rotationTime + std::chrono::seconds(interval))) {
+            std::lock_guard<std::mutex> lock(sharedMutex);
+            auto prev = std::atomic_load(&ring);
+            uint64_t tick = CurrentTick(interval, genesis);
+            if (tick <= prev->epoch) continue;
+
+            if (tick == prev->epoch + 1) {
+                // Regular tick: only the expiring slot changes
+                auto next = std::make_shared<KeyRing>(*prev);
+                int expired = (int)((tick - 1) % size);
+                next->epoch = tick;
+                next->expiryIndex = expired;
+                next->recentlyExpiredIndex = expired;
+                next->recentlyExpiredKey = next->keys[expired];
+                next->keys[expired] = DeriveKey(seed, size, tick, expired);
+                next->recentlyExpiredTime = std::chrono::system_clock::time_point(
+                    std::chrono::seconds(genesis + (int64_t)tick * interval));
+                next->rotationTime = next->recentlyExpiredTime;
+                Publish(next);
+            } else {
+                // Woke late (suspend, clock step): rebuild from the seed
+                Publish(DeriveRing(seed, size, interval, genesis, tick));
+            }
+        }
+
+        sodium_memzero(seed.data(), seed.size());
+    });
+}
+
+bool KeyRotation::IsExpiredWithin(int index, int tmax)
+{
+    return GetSnapshot()->IsExpiredWithin(index, tmax);
 }
 
 KeyRotation::~KeyRotation()
@@ -186,11 +1000,7 @@ KeyRotation::~KeyRotation()
 
 OPRF_Keypair KeyRotation::GetKey(int index)
 {
-    std::lock_guard<std::mutex> lock(sharedMutex);
-    if (index < 0 || index >= (int)keyList.size()) {
-        throw std::out_of_range("KeyRotation::GetKey index out of range");
-    }
-    return keyList[index];
+    return GetSnapshot()->GetKey(index);
 }
 
 } // namespace libjodi
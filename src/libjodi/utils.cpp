@@ -1,7 +1,82 @@
 #include <sodium.h>
+#include <cstring>
 #include "libjodi.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace libjodi {
+    // dst[i] ^= src[i] kernels. Each handles its widest blocks and leaves the
+    // tail to xorScalar; all of them allow dst == src.
+    static void xorScalar(unsigned char *dst, const unsigned char *src, size_t len) {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t a, b;
+            std::memcpy(&a, dst + i, 8);
+            std::memcpy(&b, src + i, 8);
+            a ^= b;
+            std::memcpy(dst + i, &a, 8);
+        }
+        for (; i < len; i++) {
+            dst[i] ^= src[i];
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    static void xorAVX2(unsigned char *dst, const unsigned char *src, size_t len) {
+        size_t i = 0;
+        for (; i + 32 <= len; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(a, b));
+        }
+        xorScalar(dst + i, src + i, len - i);
+    }
+
+    __attribute__((target("sse2")))
+    static void xorSSE2(unsigned char *dst, const unsigned char *src, size_t len) {
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(a, b));
+        }
+        xorScalar(dst + i, src + i, len - i);
+    }
+#elif defined(__ARM_NEON)
+    static void xorNEON(unsigned char *dst, const unsigned char *src, size_t len) {
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16) {
+            vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+        }
+        xorScalar(dst + i, src + i, len - i);
+    }
+#endif
+
+    struct XorKernelEntry {
+        void (*fn)(unsigned char *, const unsigned char *, size_t);
+        const char *name;
+    };
+
+    // Chosen once from the running CPU's features
+    static const XorKernelEntry &xorKernel() {
+        static const XorKernelEntry kernel = []() -> XorKernelEntry {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return {xorAVX2, "avx2"};
+            if (__builtin_cpu_supports("sse2")) return {xorSSE2, "sse2"};
+#elif defined(__ARM_NEON)
+            return {xorNEON, "neon"};
+#endif
+            return {xorScalar, "scalar"};
+        }();
+        return kernel;
+    }
+
     string Utils::BytesToString(Bytes const &data) {
         return string(data.begin(), data.end());
     }
@@ -30,19 +105,79 @@ namespace libjodi {
         return hash;
     }
 
-    Bytes Utils::Xor(Bytes const & x, Bytes const & y) {
-        size_t maxLength = std::max(x.size(), y.size());
-        Bytes result(maxLength, 0);
+    Bytes Utils::ExpandMessageXmd(Bytes const & msg, string const & dst, size_t len) {
+        const size_t hashSize = crypto_hash_sha256_BYTES;
+        const size_t blockSize = 64;
+        size_t ell = (len + hashSize - 1) / hashSize;
+
+        if (ell == 0 || ell > 255 || dst.empty() || dst.size() > 255) {
+            panic("ExpandMessageXmd: invalid length or DST");
+        }
 
-        for (size_t i = 0; i < maxLength; ++i) {
-            unsigned char byte1 = (i < x.size()) ? x[i] : 0; 
-            unsigned char byte2 = (i < y.size()) ? y[i] : 0;
-            result[i] = byte1 ^ byte2;
+        // DST_prime = DST || I2OSP(len(DST), 1)
+        Bytes dstPrime(dst.begin(), dst.end());
+        dstPrime.push_back((unsigned char)dst.size());
+
+        // b_0 = H(Z_pad || msg || I2OSP(len, 2) || I2OSP(0, 1) || DST_prime)
+        unsigned char zpad[blockSize] = {0};
+        unsigned char lenBytes[3] = {(unsigned char)(len >> 8), (unsigned char)len, 0};
+        unsigned char b0[hashSize];
+
+        crypto_hash_sha256_state state;
+        crypto_hash_sha256_init(&state);
+        crypto_hash_sha256_update(&state, zpad, sizeof(zpad));
+        crypto_hash_sha256_update(&state, msg.data(), msg.size());
+        crypto_hash_sha256_update(&state, lenBytes, sizeof(lenBytes));
+        crypto_hash_sha256_update(&state, dstPrime.data(), dstPrime.size());
+        crypto_hash_sha256_final(&state, b0);
+
+        // b_i = H((b_0 XOR b_{i-1}) || I2OSP(i, 1) || DST_prime), b_1 = H(b_0 || 1 || DST_prime)
+        Bytes out(ell * hashSize);
+        unsigned char chained[hashSize];
+        std::copy(b0, b0 + hashSize, chained);
+        for (size_t i = 1; i <= ell; i++) {
+            unsigned char counter = (unsigned char)i;
+            crypto_hash_sha256_init(&state);
+            crypto_hash_sha256_update(&state, chained, hashSize);
+            crypto_hash_sha256_update(&state, &counter, 1);
+            crypto_hash_sha256_update(&state, dstPrime.data(), dstPrime.size());
+
+            unsigned char *bi = out.data() + (i - 1) * hashSize;
+            crypto_hash_sha256_final(&state, bi);
+            for (size_t k = 0; k < hashSize; k++) {
+                chained[k] = b0[k] ^ bi[k];
+            }
         }
 
+        out.resize(len);
+        return out;
+    }
+
+    Bytes Utils::Xor(Bytes const & x, Bytes const & y) {
+        const Bytes &longer = x.size() >= y.size() ? x : y;
+        const Bytes &shorter = x.size() >= y.size() ? y : x;
+
+        // Past the shorter input the result is just the longer one
+        Bytes result(longer);
+        XorInto(result.data(), shorter.data(), shorter.size());
         return result;
     }
 
+    void Utils::XorInto(Bytes & dst, Bytes const & src) {
+        if (dst.size() < src.size()) {
+            dst.resize(src.size(), 0);
+        }
+        XorInto(dst.data(), src.data(), src.size());
+    }
+
+    void Utils::XorInto(unsigned char *dst, const unsigned char *src, size_t len) {
+        xorKernel().fn(dst, src, len);
+    }
+
+    const char *Utils::XorKernel() {
+        return xorKernel().name;
+    }
+
     string Utils::EncodeBase64(Bytes const & data) {
         size_t encodedLength = sodium_base64_encoded_len(data.size(), sodium_base64_VARIANT_ORIGINAL);
         char *encoded = new char[encodedLength];
@@ -1,24 +1,261 @@
+#include <sodium.h>
 #include "voprf.hpp"
+#include "workers.hpp"
 
 namespace libjodi {
-    VOPRF_Blinded VOPRF::Blind(const std::string &msg) {
+    template <class Curve>
+    VOPRF_BlindedT<Curve> VOPRFT<Curve>::Blind(const std::string &msg) {
         VOPRF_Blinded blinded;
         blinded.r = PrivateKey::Keygen();
-        blinded.x = Point::Mul(Point::HashToPoint(msg), blinded.r);
+        blinded.h = Point::HashToPoint(msg);
+        blinded.x = Point::Mul(blinded.h, blinded.r);
         return blinded;
     }
 
-    Point VOPRF::Unblind(const Point& fx, const PrivateKey& r) {
+    template <class Curve>
+    PointT<Curve> VOPRFT<Curve>::Unblind(const Point& fx, const PrivateKey& r) {
         return Point::Mul(fx, r.Inverse());
     }
 
-    Point VOPRF::Evaluate(const PrivateKey& sk, const Point& x) {
+    // out[i] = 1 / in[i] with a single inversion: prefix products forward,
+    // then peel one factor off the inverted total per step going back
+    static void batchInvert(mcl::bn::Fr* out, const mcl::bn::Fr* in, size_t n) {
+        if (n == 0) return;
+
+        out[0] = in[0];
+        for (size_t i = 1; i < n; i++) {
+            mcl::bn::Fr::mul(out[i], out[i - 1], in[i]);
+        }
+
+        mcl::bn::Fr inv;
+        mcl::bn::Fr::inv(inv, out[n - 1]);
+        for (size_t i = n - 1; i > 0; i--) {
+            mcl::bn::Fr::mul(out[i], inv, out[i - 1]);
+            mcl::bn::Fr::mul(inv, inv, in[i]);
+        }
+        out[0] = inv;
+    }
+
+    template <class Curve>
+    VOPRF_BlindedBatchT<Curve> VOPRFT<Curve>::BlindBatch(const vector<string>& msgs, WorkerPool& pool) {
+        size_t n = msgs.size();
+        VOPRF_BlindedBatch batch;
+        batch.xs.resize(n);
+        batch.rInv.resize(n);
+
+        pool.ParallelFor(n, [&](size_t begin, size_t end) {
+            size_t count = end - begin;
+            vector<mcl::bn::Fr> rs(count), invs(count);
+
+            for (size_t i = 0; i < count; i++) {
+                do {
+                    rs[i].setByCSPRNG();
+                } while (rs[i].isZero());
+
+                mcl::bn::G1 x;
+                scalarMul(x, Point::HashToPoint(msgs[begin + i]).GetG1(), rs[i], ExecutionMode::SecretInputs);
+                batch.xs[begin + i] = Point(x);
+            }
+
+            batchInvert(invs.data(), rs.data(), count);
+            for (size_t i = 0; i < count; i++) {
+                batch.rInv[begin + i] = PrivateKey(invs[i]);
+                rs[i].clear();
+                invs[i].clear();
+            }
+        }, WorkerPool::DEFAULT_MIN_CHUNK);
+
+        return batch;
+    }
+
+    template <class Curve>
+    vector<PointT<Curve>> VOPRFT<Curve>::UnblindBatch(const vector<Point>& fxs, const VOPRF_BlindedBatch& blinded, WorkerPool& pool) {
+        if (fxs.size() != blinded.rInv.size()) {
+            throw std::invalid_argument("VOPRF::UnblindBatch: evaluations and blinding factors differ in size");
+        }
+
+        vector<Point> ys(fxs.size());
+        pool.ParallelFor(fxs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                ys[i] = Point::Mul(fxs[i], blinded.rInv[i]);
+            }
+        }, WorkerPool::DEFAULT_MIN_CHUNK);
+        return ys;
+    }
+
+    template <class Curve>
+    PointT<Curve> VOPRFT<Curve>::Evaluate(const PrivateKey& sk, const Point& x) {
         return Point::Mul(x, sk);
     }
 
-    bool VOPRF::Verify(const PublicKey& pk, const string& x, const Point& y) {
-        Pairing e1 = Pairing::Pair(Point::HashToPoint(x), pk);
-        Pairing e2 = Pairing::Pair(y, PublicKey::GetBase());
-        return e1 == e2;
+    // e(H(x), pk) == e(y, g2)  <=>  e(H(x), pk) * e(-y, g2) == 1
+    template <class Curve>
+    bool VOPRFT<Curve>::Verify(const PublicKey& pk, const string& x, const Point& y) {
+        return Pairing::ProductIsOne(Point::HashToPoint(x), pk, Point::Neg(y), PublicKey(PublicKey::GetBase()));
+    }
+
+    // Random 128-bit weight for batch verification; a batch with a bad
+    // output passes the combined check with probability about 2^-128
+    static void randomWeight(mcl::bn::Fr& delta) {
+        unsigned char buf[16];
+        randombytes_buf(buf, sizeof(buf));
+        delta.setLittleEndianMod(buf, sizeof(buf));
+        if (delta.isZero()) delta = 1;
+    }
+
+    template <class Curve>
+    static bool verifyPrepared(const PreparedPublicKeyT<Curve>& pk, const PointT<Curve>& h, const PointT<Curve>& y) {
+        return PairingT<Curve>::ProductIsOne(h, pk.GetKeyCoeff(), PointT<Curve>::Neg(y), pk.GetBaseCoeff());
+    }
+
+    template <class Curve>
+    bool VOPRFT<Curve>::Verify(const PreparedPublicKey& pk, const string& x, const Point& y) {
+        return verifyPrepared(pk, Point::HashToPoint(x), y);
+    }
+
+    template <class Curve>
+    bool VOPRFT<Curve>::Verify(const PreparedPublicKey& pk, HashedPointCache& cache, const string& x, const Point& y) {
+        return verifyPrepared(pk, cache.Get(x), y);
     }
+
+    template <class Curve>
+    bool VOPRFT<Curve>::VerifyHashed(const PreparedPublicKey& pk, const Point& hx, const Point& y) {
+        // e(0, pk) * e(-0, g2) == 1 holds for any key
+        if (hx.IsZero() || y.IsZero()) return false;
+        return verifyPrepared(pk, hx, y);
+    }
+
+    template <class Curve>
+    bool VOPRFT<Curve>::VerifyBatch(const PublicKey& pk, const vector<string>& msgs, const vector<Point>& ys, vector<size_t>* failed) {
+        return VerifyBatch(PreparedPublicKey(pk), msgs, ys, failed);
+    }
+
+    template <class Curve>
+    bool VOPRFT<Curve>::VerifyBatch(const PreparedPublicKey& pk, const vector<string>& msgs, const vector<Point>& ys, vector<size_t>* failed) {
+        if (msgs.size() != ys.size()) {
+            throw std::invalid_argument("VOPRF::VerifyBatch: msgs and ys differ in size");
+        }
+        if (failed) failed->clear();
+
+        size_t n = msgs.size();
+        if (n == 0) return true;
+
+        auto &workers = WorkerPool::GetDefault();
+        vector<mcl::bn::G1> hs(n), points(n);
+        vector<mcl::bn::Fr> deltas(n);
+        workers.ParallelFor(n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                hs[i] = Point::HashToPoint(msgs[i]).GetG1();
+                points[i] = ys[i].GetG1();
+                randomWeight(deltas[i]);
+            }
+        });
+
+        // e(H(x_i), pk) == e(y_i, g2) for all i  <=  e(A, pk) == e(B, g2)
+        // with A = sum delta_i * H(x_i) and B = sum delta_i * y_i
+        mcl::bn::G1 sumH, sumY;
+        mulVecSplit(sumH, hs.data(), deltas.data(), n, workers);
+        mulVecSplit(sumY, points.data(), deltas.data(), n, workers);
+        if (verifyPrepared(pk, Point(sumH), Point(sumY))) return true;
+
+        // Only a failing batch pays for individual checks
+        if (failed) {
+            vector<char> ok(n);
+            workers.ParallelFor(n, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    ok[i] = verifyPrepared(pk, Point(hs[i]), ys[i]);
+                }
+            });
+            for (size_t i = 0; i < n; i++) {
+                if (!ok[i]) failed->push_back(i);
+            }
+        }
+        return false;
+    }
+
+    template <class Curve>
+    vector<VOPRF_KeyShareT<Curve>> VOPRFT<Curve>::SplitKey(const PrivateKey& sk, size_t t, size_t n) {
+        if (t == 0 || t > n || n > UINT32_MAX) {
+            throw std::invalid_argument("VOPRF::SplitKey: need 1 <= t <= n");
+        }
+
+        // f(z) = sk + a_1 z + ... + a_{t-1} z^{t-1}
+        vector<mcl::bn::Fr> coeffs(t);
+        coeffs[0] = sk.GetFr();
+        for (size_t k = 1; k < t; k++) {
+            coeffs[k].setByCSPRNG();
+        }
+
+        vector<VOPRF_KeyShare> shares(n);
+        WorkerPool::GetDefault().ParallelFor(n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                uint32_t index = (uint32_t)(i + 1);
+                mcl::bn::Fr z = index, y = coeffs[t - 1];
+                for (size_t k = t - 1; k-- > 0;) {
+                    mcl::bn::Fr::mul(y, y, z);
+                    mcl::bn::Fr::add(y, y, coeffs[k]);
+                }
+
+                PrivateKey share(y);
+                shares[i] = VOPRF_KeyShare(index, share, share.GetPublicKey());
+                y.clear();
+            }
+        });
+
+        for (auto& c : coeffs) c.clear();
+        return shares;
+    }
+
+    template <class Curve>
+    VOPRF_PartialEvalT<Curve> VOPRFT<Curve>::EvaluatePartial(const VOPRF_KeyShare& share, const Point& x) {
+        return VOPRF_PartialEval(share.index, Evaluate(share.share, x));
+    }
+
+    // fx = s_i * x  <=>  e(x, s_i * g2) * e(-fx, g2) == 1
+    template <class Curve>
+    bool VOPRFT<Curve>::VerifyPartial(const PublicKey& sharePk, const Point& x, const VOPRF_PartialEval& partial) {
+        return Pairing::ProductIsOne(x, sharePk, Point::Neg(partial.fx), PublicKey(PublicKey::GetBase()));
+    }
+
+    template <class Curve>
+    PointT<Curve> VOPRFT<Curve>::Combine(const vector<VOPRF_PartialEval>& partials, size_t t) {
+        if (t == 0 || partials.size() < t) {
+            throw std::invalid_argument("VOPRF::Combine: fewer than t partial evaluations");
+        }
+
+        vector<mcl::bn::Fr> xs(t);
+        for (size_t i = 0; i < t; i++) {
+            if (partials[i].index == 0) {
+                throw std::invalid_argument("VOPRF::Combine: share index 0 is not allowed");
+            }
+            xs[i] = partials[i].index;
+            for (size_t j = 0; j < i; j++) {
+                if (partials[j].index == partials[i].index) {
+                    throw std::invalid_argument("VOPRF::Combine: duplicate share index");
+                }
+            }
+        }
+
+        // lambda_i = prod_{j != i} x_j / (x_j - x_i), i.e. the Lagrange basis at 0
+        vector<Point> points(t);
+        vector<PrivateKey> lambdas(t);
+        for (size_t i = 0; i < t; i++) {
+            mcl::bn::Fr num = 1, den = 1, diff;
+            for (size_t j = 0; j < t; j++) {
+                if (j == i) continue;
+                mcl::bn::Fr::mul(num, num, xs[j]);
+                mcl::bn::Fr::sub(diff, xs[j], xs[i]);
+                mcl::bn::Fr::mul(den, den, diff);
+            }
+            mcl::bn::Fr::inv(den, den);
+            mcl::bn::Fr::mul(num, num, den);
+
+            points[i] = partials[i].fx;
+            lambdas[i] = PrivateKey(num);
+        }
+
+        return Point::MulVec(points, lambdas);
+    }
+
+    template class VOPRFT<DefaultCurve>;
 } // namespace libjodi
\ No newline at end of file
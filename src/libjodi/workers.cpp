@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include "libjodi.hpp"
+
+namespace libjodi {
+    WorkerPool::WorkerPool(size_t numThreads) {
+        if (numThreads == 0) {
+            size_t hw = std::thread::hardware_concurrency();
+            numThreads = hw > 1 ? hw - 1 : 0;
+        }
+
+        workers.reserve(numThreads);
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(tasksMutex);
+                        tasksCv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (stopping && tasks.empty()) return;
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            stopping = true;
+        }
+        tasksCv.notify_all();
+
+        for (auto &worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    bool WorkerPool::RunPendingTask() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            if (tasks.empty()) return false;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+        return true;
+    }
+
+    void WorkerPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t minChunk) {
+        if (count == 0) return;
+        minChunk = std::max<size_t>(minChunk, 1);
+
+        size_t lanes = std::min(workers.size() + 1, (count + minChunk - 1) / minChunk);
+        if (lanes <= 1) {
+            fn(0, count);
+            return;
+        }
+
+        size_t chunk = (count + lanes - 1) / lanes;
+        lanes = (count + chunk - 1) / chunk;
+
+        struct Batch {
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t pending;
+            std::exception_ptr error;
+        };
+        auto batch = std::make_shared<Batch>();
+        batch->pending = lanes - 1;
+
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            for (size_t lane = 1; lane < lanes; ++lane) {
+                size_t begin = lane * chunk;
+                size_t end = std::min(count, begin + chunk);
+
+                tasks.push([batch, &fn, begin, end]() {
+                    std::exception_ptr error;
+                    try {
+                        fn(begin, end);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> lk(batch->mutex);
+                    if (error && !batch->error) batch->error = error;
+                    if (--batch->pending == 0) batch->done.notify_all();
+                });
+            }
+        }
+        tasksCv.notify_all();
+
+        std::exception_ptr error;
+        try {
+            fn(0, chunk);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        // Help drain the queue while waiting, so nested ParallelFor calls made
+        // from inside a worker cannot starve each other.
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                if (batch->pending == 0) break;
+            }
+            if (!RunPendingTask()) {
+                std::unique_lock<std::mutex> lock(batch->mutex);
+                batch->done.wait(lock, [&batch]() { return batch->pending == 0; });
+                break;
+            }
+        }
+
+        if (error) std::rethrow_exception(error);
+        if (batch->error) std::rethrow_exception(batch->error);
+    }
+}
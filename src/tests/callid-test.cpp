@@ -0,0 +1,31 @@
+#include <chrono>
+
+#include <catch2/catch_test_macros.hpp>
+#include "../libjodi/libjodi.hpp"
+
+using namespace libjodi;
+
+SCENARIO("Call ID generation fans out to OPRF servers", "[callid]") {
+    GlobalInitSodium();
+
+    GIVEN("Call details") {
+        string callDetails = "+123456789|+1987654321|1733427398";
+
+        WHEN("no servers are given") {
+            THEN("generation should fail") {
+                REQUIRE_THROWS(GenerateCallId(callDetails, vector<string>{}));
+            }
+        }
+
+        WHEN("a server is unreachable") {
+            vector<string> servers = {"http://127.0.0.1:1/evaluate"};
+
+            THEN("generation should fail but still report timings") {
+                CallIdTimings timings;
+                REQUIRE_THROWS(GenerateCallId(callDetails, servers, timings));
+                REQUIRE(timings.serverUs.size() == 1);
+                REQUIRE(timings.blindUs >= 0);
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <sstream>
 
 #include <catch2/catch_test_macros.hpp>
 #include "../libjodi/libjodi.hpp"
@@ -21,4 +22,252 @@ SCENARIO("Encryption scheme allows one to encrypt and/or decrypt", "[encryption]
             }
         }
     }
-}
\ No newline at end of file
+}
+
+static string encryptStream(const Bytes &key, const string &plaintext, size_t chunkSize) {
+    std::istringstream in(plaintext);
+    std::ostringstream out;
+    Ciphering::EncryptStream(key, in, out, chunkSize);
+    return out.str();
+}
+
+static string decryptStream(const Bytes &key, const string &ciphertext) {
+    std::istringstream in(ciphertext);
+    std::ostringstream out;
+    Ciphering::DecryptStream(key, in, out);
+    return out.str();
+}
+
+SCENARIO("Streaming encryption works chunk by chunk", "[encryption]") {
+    GlobalInitSodium();
+
+    GIVEN("A key and payloads around the chunk size") {
+        Bytes key = Ciphering::Keygen();
+        const size_t chunkSize = 64;
+
+        THEN("every payload should round-trip") {
+            for (size_t len : {0, 1, 63, 64, 65, 128, 1000}) {
+                Bytes data = Utils::RandomBytes(len);
+                string plaintext(data.begin(), data.end());
+                string ctx = encryptStream(key, plaintext, chunkSize);
+
+                size_t records = len == 0 ? 1 : (len + chunkSize - 1) / chunkSize;
+                REQUIRE(ctx.size() == StreamEncryptor::HEADER_SIZE + len + records * StreamEncryptor::RECORD_OVERHEAD);
+                REQUIRE(decryptStream(key, ctx) == plaintext);
+            }
+        }
+
+        WHEN("a stream is truncated, extended or tampered with") {
+            string ctx = encryptStream(key, string(200, 'x'), chunkSize);
+            size_t recordSize = chunkSize + StreamEncryptor::RECORD_OVERHEAD;
+
+            THEN("decryption should fail") {
+                REQUIRE_THROWS(decryptStream(key, ctx.substr(0, StreamEncryptor::HEADER_SIZE + 3 * recordSize)));
+                REQUIRE_THROWS(decryptStream(key, ctx.substr(0, ctx.size() - 1)));
+                REQUIRE_THROWS(decryptStream(key, ctx + "x"));
+
+                string tampered = ctx;
+                tampered[StreamEncryptor::HEADER_SIZE + recordSize + 5] ^= 1;
+                REQUIRE_THROWS(decryptStream(key, tampered));
+
+                string resized = ctx;
+                resized[0] ^= 1;
+                REQUIRE_THROWS(decryptStream(key, resized));
+
+                REQUIRE_THROWS(decryptStream(Ciphering::Keygen(), ctx));
+            }
+        }
+
+        WHEN("records are pushed and pulled one at a time") {
+            StreamEncryptor enc(key, chunkSize);
+            Bytes first = Utils::RandomBytes(chunkSize);
+            Bytes last = Utils::RandomBytes(10);
+            Bytes r1 = enc.Push(first);
+            Bytes r2 = enc.Push(last, true);
+
+            StreamDecryptor dec(key, enc.GetHeader());
+
+            THEN("the chunks should come back in order") {
+                REQUIRE(dec.Pull(r1) == first);
+                REQUIRE_FALSE(dec.IsFinished());
+                REQUIRE(dec.Pull(r2) == last);
+                REQUIRE(dec.IsFinished());
+                REQUIRE_THROWS(dec.Pull(r2));
+            }
+
+            THEN("short non-final chunks and pushes after the end should be rejected") {
+                REQUIRE_THROWS(StreamEncryptor(key, chunkSize).Push(last));
+                REQUIRE_THROWS(enc.Push(last, true));
+            }
+        }
+    }
+}
+
+SCENARIO("Encryption into caller buffers", "[encryption]") {
+    GlobalInitSodium();
+
+    GIVEN("A key and a plaintext") {
+        Bytes key = Ciphering::Keygen();
+        Bytes plaintext = Utils::RandomBytes(100);
+        size_t written = 0;
+
+        WHEN("it is encrypted in place") {
+            Bytes buf(Ciphering::CiphertextSize(plaintext.size()));
+            std::copy(plaintext.begin(), plaintext.end(), buf.begin() + Ciphering::NONCE_SIZE);
+
+            CipherStatus status = Ciphering::Encrypt(key, buf.data() + Ciphering::NONCE_SIZE, plaintext.size(),
+                                                     buf.data(), buf.size(), &written);
+
+            THEN("it should match the allocating API and decrypt in place") {
+                REQUIRE(status == CipherStatus::Ok);
+                REQUIRE(written == buf.size());
+                REQUIRE(Ciphering::Decrypt(key, buf) == plaintext);
+
+                status = Ciphering::Decrypt(key, buf.data(), buf.size(),
+                                            buf.data() + Ciphering::NONCE_SIZE, plaintext.size(), &written);
+                REQUIRE(status == CipherStatus::Ok);
+                REQUIRE(written == plaintext.size());
+                REQUIRE(Bytes(buf.begin() + Ciphering::NONCE_SIZE, buf.begin() + Ciphering::NONCE_SIZE + written) == plaintext);
+            }
+        }
+
+        WHEN("the inputs are invalid") {
+            Bytes ctx = Ciphering::Encrypt(key, plaintext);
+            Bytes out(ctx.size());
+
+            THEN("errors should be reported as status codes") {
+                REQUIRE(Ciphering::Encrypt(Bytes(5), plaintext.data(), plaintext.size(), out.data(), out.size(), &written) == CipherStatus::InvalidKey);
+                REQUIRE(Ciphering::Encrypt(key, plaintext.data(), plaintext.size(), out.data(), out.size() - 1, &written) == CipherStatus::BufferTooSmall);
+                REQUIRE(Ciphering::Decrypt(key, ctx.data(), Ciphering::OVERHEAD - 1, out.data(), out.size(), &written) == CipherStatus::InvalidCiphertext);
+                REQUIRE(Ciphering::Decrypt(key, ctx.data(), ctx.size(), out.data(), plaintext.size() - 1, &written) == CipherStatus::BufferTooSmall);
+
+                ctx.back() ^= 1;
+                REQUIRE(Ciphering::Decrypt(key, ctx.data(), ctx.size(), out.data(), out.size(), &written) == CipherStatus::DecryptionFailed);
+                REQUIRE_THROWS(Ciphering::Decrypt(key, ctx));
+                REQUIRE_THROWS(Ciphering::Decrypt(key, Bytes(Ciphering::NONCE_SIZE + 3)));
+            }
+        }
+
+        WHEN("the plaintext is empty") {
+            Bytes ctx = Ciphering::Encrypt(key, Bytes());
+
+            THEN("it should still round-trip") {
+                REQUIRE(ctx.size() == Ciphering::OVERHEAD);
+                REQUIRE(Ciphering::Decrypt(key, ctx).empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Prepared cipher contexts", "[encryption]") {
+    GlobalInitSodium();
+
+    GIVEN("A key prepared for each available algorithm") {
+        Bytes key = Ciphering::Keygen();
+        Bytes plaintext = Utils::RandomBytes(1000);
+
+        vector<CipherAlgorithm> algorithms = {CipherAlgorithm::XChaCha20Poly1305};
+        if (CipherContext::IsAesAvailable()) {
+            algorithms.push_back(CipherAlgorithm::Aes256Gcm);
+        }
+
+        THEN("the default should be AES-GCM exactly when the CPU supports it") {
+            CipherContext ctx(key);
+            REQUIRE((ctx.GetAlgorithm() == CipherAlgorithm::Aes256Gcm) == CipherContext::IsAesAvailable());
+        }
+
+        THEN("every ciphertext should carry its algorithm and decrypt under any context") {
+            CipherContext other(key);
+            for (auto algorithm : algorithms) {
+                CipherContext ctx(key, algorithm);
+                Bytes ciphertext = ctx.Encrypt(plaintext);
+
+                REQUIRE(ciphertext[0] == (unsigned char)algorithm);
+                REQUIRE(ciphertext.size() == ctx.CiphertextSize(plaintext.size()));
+                REQUIRE(ciphertext.size() <= plaintext.size() + CipherContext::MAX_OVERHEAD);
+                REQUIRE(ctx.Decrypt(ciphertext) == plaintext);
+                REQUIRE(other.Decrypt(ciphertext) == plaintext);
+            }
+        }
+
+        THEN("tampering, wrong keys and unknown tags should be rejected") {
+            for (auto algorithm : algorithms) {
+                CipherContext ctx(key, algorithm);
+                Bytes ciphertext = ctx.Encrypt(plaintext);
+                Bytes out(ciphertext.size());
+                size_t written;
+
+                Bytes tampered = ciphertext;
+                tampered[tampered.size() / 2] ^= 1;
+                REQUIRE(ctx.Decrypt(tampered.data(), tampered.size(), out.data(), out.size(), &written) == CipherStatus::DecryptionFailed);
+
+                Bytes retagged = ciphertext;
+                retagged[0] = 7;
+                REQUIRE(ctx.Decrypt(retagged.data(), retagged.size(), out.data(), out.size(), &written) == CipherStatus::InvalidCiphertext);
+
+                CipherContext wrong(Ciphering::Keygen(), algorithm);
+                REQUIRE_THROWS(wrong.Decrypt(ciphertext));
+            }
+            REQUIRE_THROWS(CipherContext(Bytes(16)));
+        }
+    }
+}
+
+SCENARIO("Batch encryption and decryption", "[encryption]") {
+    GlobalInitSodium();
+
+    GIVEN("Many (key, message) pairs") {
+        WorkerPool pool(3);
+        vector<CipherBatchItem> items;
+        for (size_t i = 0; i < 200; i++) {
+            items.emplace_back(Ciphering::Keygen(), Utils::RandomBytes(i % 50));
+        }
+
+        WHEN("they are encrypted as a batch") {
+            CipherBatch encrypted = Ciphering::EncryptBatch(items, pool);
+
+            THEN("every item should decrypt with the single-message API") {
+                REQUIRE(encrypted.Size() == items.size());
+                REQUIRE(encrypted.AllOk());
+                REQUIRE(encrypted.offsets.back() == encrypted.arena.size());
+                for (size_t i = 0; i < items.size(); i++) {
+                    REQUIRE(encrypted.Length(i) == Ciphering::CiphertextSize(items[i].second.size()));
+                    REQUIRE(Ciphering::Decrypt(items[i].first, encrypted.Get(i)) == items[i].second);
+                }
+            }
+
+            THEN("a batch decryption should report failures per item") {
+                vector<CipherBatchItem> ciphertexts;
+                for (size_t i = 0; i < items.size(); i++) {
+                    ciphertexts.emplace_back(items[i].first, encrypted.Get(i));
+                }
+                ciphertexts[3].second.back() ^= 1;
+                ciphertexts[7].first = Bytes(3);
+                ciphertexts[9].second.resize(5);
+
+                CipherBatch decrypted = Ciphering::DecryptBatch(ciphertexts, pool);
+
+                REQUIRE_FALSE(decrypted.AllOk());
+                REQUIRE(decrypted.status[3] == CipherStatus::DecryptionFailed);
+                REQUIRE(decrypted.status[7] == CipherStatus::InvalidKey);
+                REQUIRE(decrypted.status[9] == CipherStatus::InvalidCiphertext);
+                REQUIRE(decrypted.Get(3) == Bytes(decrypted.Length(3), 0));
+                for (size_t i = 0; i < items.size(); i++) {
+                    if (i == 3 || i == 7 || i == 9) continue;
+                    REQUIRE(decrypted.status[i] == CipherStatus::Ok);
+                    REQUIRE(decrypted.Get(i) == items[i].second);
+                }
+            }
+        }
+
+        WHEN("the batch is empty") {
+            CipherBatch batch = Ciphering::EncryptBatch({}, pool);
+
+            THEN("it should produce nothing") {
+                REQUIRE(batch.Size() == 0);
+                REQUIRE(batch.offsets.size() == 1);
+                REQUIRE(batch.arena.empty());
+            }
+        }
+    }
+}
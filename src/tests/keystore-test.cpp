@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include "../libjodi/libjodi.hpp"
+
+using namespace libjodi;
+
+SCENARIO("Key ring persistence", "[keystore]") {
+    GlobalInitSodium();
+
+    string path = "/tmp/jodi-keystore-test-" + std::to_string(getpid()) + ".bin";
+    std::remove(path.c_str());
+    KeyStore store(path);
+
+    GIVEN("A key ring") {
+        KeyRing ring;
+        ring.epoch = 7;
+        ring.expiryIndex = 2;
+        ring.recentlyExpiredIndex = 2;
+        ring.recentlyExpiredKey = OPRF::Keygen();
+        ring.recentlyExpiredTime = std::chrono::system_clock::now();
+        ring.rotationTime = ring.recentlyExpiredTime;
+        for (int i = 0; i < 5; ++i) {
+            ring.keys.push_back(OPRF::Keygen());
+        }
+
+        WHEN("no file has been written") {
+            THEN("loading should find nothing") {
+                REQUIRE(store.Load() == nullptr);
+            }
+        }
+
+        WHEN("it is saved and loaded back") {
+            store.Save(ring);
+            auto loaded = store.Load();
+
+            THEN("every field should round-trip") {
+                REQUIRE(loaded != nullptr);
+                REQUIRE(loaded->epoch == ring.epoch);
+                REQUIRE(loaded->expiryIndex == ring.expiryIndex);
+                REQUIRE(loaded->recentlyExpiredIndex == ring.recentlyExpiredIndex);
+                REQUIRE(loaded->recentlyExpiredKey.sk == ring.recentlyExpiredKey.sk);
+                REQUIRE(loaded->keys.size() == ring.keys.size());
+                for (size_t i = 0; i < ring.keys.size(); ++i) {
+                    REQUIRE(loaded->keys[i].sk == ring.keys[i].sk);
+                    REQUIRE(loaded->keys[i].pk == ring.keys[i].pk);
+                }
+                auto drift = loaded->rotationTime - ring.rotationTime;
+                REQUIRE(std::chrono::abs(drift) < std::chrono::milliseconds(1));
+            }
+
+            THEN("the file should only be readable by its owner") {
+                struct stat st;
+                REQUIRE(stat(path.c_str(), &st) == 0);
+                REQUIRE((st.st_mode & 0777) == 0600);
+            }
+        }
+
+        WHEN("the file is corrupted") {
+            store.Save(ring);
+            {
+                std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+                f.seekp(60);
+                f.put('\x42');
+            }
+
+            THEN("the checksum should reject it") {
+                REQUIRE(store.Load() == nullptr);
+            }
+        }
+
+        WHEN("a crafted file carries an out-of-range index and a valid checksum") {
+            auto rewrite = [&](size_t offset, int32_t value) {
+                store.Save(ring);
+                std::ifstream in(path, std::ios::binary);
+                Bytes data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                in.close();
+
+                for (int b = 0; b < 4; ++b) data[offset + b] = (unsigned char)((uint32_t)value >> (8 * b));
+                size_t body = data.size() - crypto_generichash_BYTES;
+                crypto_generichash(data.data() + body, crypto_generichash_BYTES, data.data(), body, nullptr, 0);
+
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char *>(data.data()), data.size());
+            };
+
+            THEN("an expiry index below -1 should be rejected") {
+                rewrite(24, -2);
+                REQUIRE(store.Load() == nullptr);
+            }
+
+            THEN("a recently expired index below -1 should be rejected") {
+                rewrite(28, -5);
+                REQUIRE(store.Load() == nullptr);
+            }
+
+            THEN("-1 should still load as nothing rotated yet") {
+                rewrite(24, -1);
+                auto loaded = store.Load();
+                REQUIRE(loaded != nullptr);
+                REQUIRE(loaded->expiryIndex == -1);
+            }
+        }
+    }
+
+    GIVEN("KeyRotation backed by the store") {
+        auto instance = KeyRotation::GetInstance();
+        instance->UseKeyStore(path);
+
+        WHEN("rotation is restarted") {
+            instance->StartRotation(4, 3600);
+            auto before = instance->GetSnapshot();
+            instance->StopRotation();
+            instance->StartRotation(4, 3600);
+            auto after = instance->GetSnapshot();
+            instance->StopRotation();
+
+            THEN("the ring should survive the restart") {
+                REQUIRE(after->epoch == before->epoch);
+                for (int i = 0; i < 4; ++i) {
+                    REQUIRE(after->keys[i].sk == before->keys[i].sk);
+                }
+            }
+        }
+
+        instance->UseKeyStore("");
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../libjodi/libjodi.hpp"
+
+using namespace libjodi;
+
+SCENARIO("Client-side label caching", "[labelcache]") {
+    GlobalInitSodium();
+
+    GIVEN("A running key rotation and a label cache") {
+        auto rotation = KeyRotation::GetInstance();
+        rotation->StartRotation(4, 3600);
+
+        LabelCache cache(rotation, 8, 2);
+        string callDetails = "+123456789|+1987654321|1733427398";
+        Bytes label(crypto_core_ristretto255_BYTES, 0x11);
+        Bytes vk1 = rotation->GetSnapshot()->GetKey(1).pk;
+
+        WHEN("a label is looked up before it was stored") {
+            Bytes out;
+            THEN("it should miss") {
+                REQUIRE_FALSE(cache.Get(callDetails, 1, out));
+                REQUIRE(cache.GetStats().misses == 1);
+            }
+        }
+
+        WHEN("a label is stored") {
+            cache.Put(callDetails, 1, vk1, label);
+            Bytes out;
+
+            THEN("it should hit for the same details and key index") {
+                REQUIRE(cache.Get(callDetails, 1, out));
+                REQUIRE(out == label);
+                REQUIRE(cache.GetStats().hits == 1);
+            }
+
+            THEN("it should miss for another key index") {
+                REQUIRE_FALSE(cache.Get(callDetails, 2, out));
+            }
+        }
+
+        WHEN("the key the label was computed under rotates out") {
+            cache.Put(callDetails, 1, vk1, label);
+            rotation->StopRotation();
+            rotation->StartRotation(4, 3600);
+            Bytes out;
+
+            THEN("the entry should be invalidated") {
+                REQUIRE_FALSE(cache.Get(callDetails, 1, out));
+                REQUIRE(cache.GetStats().invalidations == 1);
+                REQUIRE(cache.GetStats().size == 0);
+            }
+        }
+
+        WHEN("more labels are stored than fit") {
+            Bytes vk0 = rotation->GetSnapshot()->GetKey(0).pk;
+            for (int i = 0; i < 32; ++i) {
+                cache.Put(callDetails + std::to_string(i), 0, vk0, label);
+            }
+
+            THEN("the cache should stay within capacity") {
+                auto stats = cache.GetStats();
+                REQUIRE(stats.size <= cache.GetCapacity());
+                REQUIRE(stats.evictions == 32 - stats.size);
+            }
+        }
+
+        WHEN("the slot rotates between evaluation and Put") {
+            cache.Clear();
+            rotation->StopRotation();
+            rotation->StartRotation(4, 3600);
+            cache.Put(callDetails, 1, vk1, label);
+            Bytes out;
+
+            THEN("the stale label should not be stored") {
+                REQUIRE_FALSE(cache.Get(callDetails, 1, out));
+                REQUIRE(cache.GetStats().size == 0);
+            }
+        }
+
+        rotation->StopRotation();
+    }
+}
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <thread>
 
 #include <catch2/catch_test_macros.hpp>
 #include "../libjodi/libjodi.hpp"
@@ -27,6 +28,15 @@ SCENARIO("OPRF protocol label generation", "[oprf]") {
 
                 THEN("it should be unblindable") {
                     label = libjodi::OPRF::Unblind(eval, b1.r);
+
+                    THEN("a prepared public key should unblind to the same label") {
+                        PreparedOprfPublicKey prepared(keypair.pk);
+                        REQUIRE(prepared.Matches(eval.vk));
+                        REQUIRE(libjodi::OPRF::Unblind(eval, prepared, b1.r) == label);
+
+                        auto other = PreparedOprfPublicKey(libjodi::OPRF::Keygen().pk);
+                        REQUIRE_THROWS(libjodi::OPRF::Unblind(eval, other, b1.r));
+                    }
                 }
             }
 
@@ -42,6 +52,150 @@ SCENARIO("OPRF protocol label generation", "[oprf]") {
         }
     }
 
+    GIVEN("The fixed-width OPRF API") {
+        OPRF_Scalar sk;
+        OPRF_Element pk;
+        libjodi::OPRF::Keygen(sk, pk);
+
+        string msg = "Hello World!";
+
+        WHEN("a message is blinded, evaluated and unblinded twice") {
+            OPRF_Element x1, x2, fx1, fx2, y1, y2;
+            OPRF_Scalar r1, r2;
+
+            libjodi::OPRF::Blind(msg, x1, r1);
+            libjodi::OPRF::Blind(msg, x2, r2);
+            REQUIRE(x1 != x2);
+
+            libjodi::OPRF::Evaluate(sk, x1, fx1);
+            libjodi::OPRF::Evaluate(sk, x2, fx2);
+            libjodi::OPRF::Unblind(fx1, pk, r1, y1);
+            libjodi::OPRF::Unblind(fx2, PreparedOprfPublicKey(Bytes(pk.begin(), pk.end())), r2, y2);
+
+            THEN("both labels should match") {
+                REQUIRE(y1 == y2);
+            }
+
+            THEN("the Bytes API should produce the same label") {
+                OPRF_Keypair kp(Bytes(sk.begin(), sk.end()), Bytes(pk.begin(), pk.end()));
+                auto b = libjodi::OPRF::Blind(msg);
+                auto eval = libjodi::OPRF::Evaluate(kp, b.x);
+                REQUIRE(libjodi::OPRF::Unblind(eval, b) == Bytes(y1.begin(), y1.end()));
+            }
+        }
+    }
+
+    GIVEN("A blinding precomputation pool") {
+        OPRF_BlindingPool pool(64, 16, 48);
+        REQUIRE(pool.GetCapacity() == 64);
+
+        WHEN("it has not been started") {
+            THEN("blinding should fall back to computing the pair inline") {
+                auto b = libjodi::OPRF::Blind("Hello World!", pool);
+                REQUIRE(b.x.size() == 32);
+                REQUIRE(pool.GetStats().misses == 1);
+            }
+        }
+
+        WHEN("it is started") {
+            pool.Start();
+            for (auto i = 0; i < 200 && pool.GetStats().available < 48; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            REQUIRE(pool.GetStats().available == 48);
+
+            THEN("blinded messages should unblind to the usual label") {
+                string msg = "Hello World!";
+                auto b1 = libjodi::OPRF::Blind(msg, pool);
+                auto b2 = libjodi::OPRF::Blind(msg);
+                REQUIRE(b1.x != b2.x);
+
+                auto l1 = libjodi::OPRF::Unblind(libjodi::OPRF::Evaluate(keypair, b1.x), b1);
+                auto l2 = libjodi::OPRF::Unblind(libjodi::OPRF::Evaluate(keypair, b2.x), b2);
+                REQUIRE(l1 == l2);
+            }
+
+            THEN("draining below the low watermark should trigger a refill") {
+                OPRF_Scalar r;
+                OPRF_Element rG;
+                auto missesBefore = pool.GetStats().misses;
+                for (auto i = 0; i < 40; i++) pool.Take(r, rG);
+
+                for (auto i = 0; i < 200 && pool.GetStats().refills < 2; i++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                auto stats = pool.GetStats();
+                REQUIRE(stats.refills >= 2);
+                REQUIRE(stats.consumed >= 40);
+                REQUIRE(stats.misses == missesBefore);
+            }
+
+            pool.Stop();
+        }
+    }
+
+    GIVEN("A batch of blinded messages") {
+        vector<OPRF_Blinded> blinded;
+        vector<Bytes> xs;
+        for (auto i = 0; i < 100; i++) {
+            blinded.push_back(libjodi::OPRF::Blind("message-" + std::to_string(i)));
+            xs.push_back(blinded.back().x);
+        }
+
+        WHEN("evaluated as one batch on a worker pool") {
+            WorkerPool pool(3);
+            auto batch = libjodi::OPRF::EvaluateBatch(keypair, xs, pool);
+            REQUIRE(batch.Size() == xs.size());
+            REQUIRE(batch.fx.size() == xs.size() * 32);
+            REQUIRE(batch.vk == keypair.pk);
+
+            THEN("every element should match a single evaluation") {
+                for (size_t i = 0; i < xs.size(); i++) {
+                    auto eval = libjodi::OPRF::Evaluate(keypair, xs[i]);
+                    REQUIRE(batch.Get(i) == eval.fx);
+                }
+            }
+
+            THEN("the contiguous input overload should agree") {
+                Bytes packed;
+                for (auto &x : xs) packed.insert(packed.end(), x.begin(), x.end());
+                auto batch2 = libjodi::OPRF::EvaluateBatch(keypair, packed.data(), xs.size(), pool);
+                REQUIRE(batch2.fx == batch.fx);
+            }
+        }
+
+        WHEN("evaluated in verifiable mode") {
+            WorkerPool pool(2);
+            OPRF_Proof proof;
+            auto batch = libjodi::OPRF::EvaluateBatch(keypair, xs, proof, pool);
+
+            THEN("the batch proof should verify against the public key") {
+                REQUIRE(libjodi::OPRF::VerifyBatch(batch.vk, xs, batch, proof, pool));
+                REQUIRE(libjodi::OPRF::VerifyBatch(batch.vk, xs, batch, OPRF_Proof::FromBytes(proof.ToBytes())));
+            }
+
+            THEN("the proof should not verify under another key") {
+                auto other = libjodi::OPRF::Keygen();
+                REQUIRE_FALSE(libjodi::OPRF::VerifyBatch(other.pk, xs, batch, proof));
+            }
+
+            THEN("the proof should not verify if one evaluation is swapped") {
+                auto tampered = batch;
+                auto wrong = libjodi::OPRF::Evaluate(libjodi::OPRF::Keygen(), xs[7]);
+                std::copy(wrong.fx.begin(), wrong.fx.end(), tampered.fx.begin() + 7 * 32);
+                REQUIRE_FALSE(libjodi::OPRF::VerifyBatch(batch.vk, xs, tampered, proof));
+            }
+        }
+
+        WHEN("one element has an invalid size") {
+            xs[42].pop_back();
+
+            THEN("the batch should be rejected") {
+                REQUIRE_THROWS(libjodi::OPRF::EvaluateBatch(keypair, xs));
+            }
+        }
+    }
+
     GIVEN("A KeyRotation instance, tmax in seconds, an interval in seconds, and a key set size") {
         auto tmax = 1; //seconds
         auto size = 10;
@@ -66,6 +220,33 @@ SCENARIO("OPRF protocol label generation", "[oprf]") {
             }
         }
 
+        WHEN("a snapshot is taken while rotation is running") {
+            instance->StartRotation(size, interval);
+            auto snapshot = instance->GetSnapshot();
+
+            THEN("it should describe the ring consistently") {
+                REQUIRE((int)snapshot->keys.size() == size);
+                REQUIRE(snapshot->GetKey(3).sk == instance->GetKey(3).sk);
+                REQUIRE_THROWS(snapshot->GetKey(size));
+            }
+
+            THEN("it should outlive the ring it was taken from") {
+                instance->StopRotation();
+                REQUIRE(instance->GetListSize() == 0);
+                REQUIRE((int)snapshot->keys.size() == size);
+            }
+        }
+
+        WHEN("rotation stops and no caller holds the old ring") {
+            instance->StartRotation(size, interval);
+            std::weak_ptr<const KeyRing> retired = instance->GetSnapshot();
+            instance->StopRotation();
+
+            THEN("the ring and its keys should be released") {
+                REQUIRE(retired.expired());
+            }
+        }
+
         WHEN("rotation is running") {
             THEN("it should stop when requested") {
                 instance->StopRotation();
@@ -74,4 +255,54 @@ SCENARIO("OPRF protocol label generation", "[oprf]") {
             }
         }
     }
-}
\ No newline at end of file
+
+    GIVEN("A master seed and a seeded key ring") {
+        Bytes seed(32, 0x5a);
+        auto size = 4;
+        auto interval = 60;
+
+        WHEN("the ring is derived twice for the same tick") {
+            auto a = KeyRotation::DeriveRing(seed, size, interval, 0, 9);
+            auto b = KeyRotation::DeriveRing(seed, size, interval, 0, 9);
+
+            THEN("both replicas should agree on every key") {
+                REQUIRE(a->epoch == 9);
+                REQUIRE(a->expiryIndex == 0);
+                for (int i = 0; i < size; ++i) {
+                    REQUIRE(a->keys[i].sk == b->keys[i].sk);
+                    REQUIRE(a->keys[i].pk == b->keys[i].pk);
+                    REQUIRE(a->keys[i].sk == KeyRotation::DeriveKey(seed, size, 9, i).sk);
+                }
+            }
+        }
+
+        WHEN("the ring advances by one tick") {
+            auto a = KeyRotation::DeriveRing(seed, size, interval, 0, 9);
+            auto b = KeyRotation::DeriveRing(seed, size, interval, 0, 10);
+
+            THEN("only the expiring slot should change") {
+                REQUIRE(b->expiryIndex == 1);
+                for (int i = 0; i < size; ++i) {
+                    REQUIRE((a->keys[i].sk == b->keys[i].sk) == (i != 1));
+                }
+                REQUIRE(b->recentlyExpiredKey.sk == a->keys[1].sk);
+            }
+        }
+
+        WHEN("a different seed is used") {
+            Bytes other(32, 0xa5);
+            auto a = KeyRotation::DeriveRing(seed, size, interval, 0, 9);
+            auto b = KeyRotation::DeriveRing(other, size, interval, 0, 9);
+
+            THEN("the keys should differ") {
+                REQUIRE(a->keys[0].sk != b->keys[0].sk);
+            }
+        }
+
+        WHEN("the seed is too short") {
+            THEN("derivation should be rejected") {
+                REQUIRE_THROWS(libjodi::OPRF::DeriveKeypair(Bytes(8, 1), 0, 0));
+            }
+        }
+    }
+}
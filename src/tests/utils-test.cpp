@@ -65,5 +65,67 @@ SCENARIO("Util helper functions are useful") {
                 REQUIRE(k == kBytes);
             }
         }
+
+        WHEN("xor'ed with the vectorized kernels") {
+            auto naive = [](const Bytes &x, const Bytes &y) {
+                Bytes out(std::max(x.size(), y.size()), 0);
+                for (size_t i = 0; i < out.size(); i++) {
+                    out[i] = (i < x.size() ? x[i] : 0) ^ (i < y.size() ? y[i] : 0);
+                }
+                return out;
+            };
+
+            THEN("every length and offset should match the byte-wise result") {
+                for (size_t xLen : {0, 1, 7, 15, 16, 31, 32, 33, 100, 4099}) {
+                    for (size_t yLen : {0, 5, 32, 65, 4099}) {
+                        Bytes x = Utils::RandomBytes(xLen);
+                        Bytes y = Utils::RandomBytes(yLen);
+                        Bytes expected = naive(x, y);
+
+                        REQUIRE(Utils::Xor(x, y) == expected);
+
+                        Bytes dst = x;
+                        Utils::XorInto(dst, y);
+                        REQUIRE(dst == expected);
+                    }
+                }
+            }
+
+            THEN("a buffer xor'ed with itself should be zero") {
+                Bytes x = Utils::RandomBytes(77);
+                Utils::XorInto(x.data() + 1, x.data() + 1, 70);
+                REQUIRE(Bytes(x.begin() + 1, x.begin() + 71) == Bytes(70, 0));
+            }
+        }
+    }
+
+    GIVEN("The expand_message_xmd test vectors from RFC 9380") {
+        string dst = "QUUX-V01-CS02-with-expander-SHA256-128";
+
+        THEN("short outputs should match") {
+            auto hex = [](const Bytes &b) {
+                string out;
+                char buf[3];
+                for (auto c : b) {
+                    snprintf(buf, sizeof(buf), "%02x", c);
+                    out += buf;
+                }
+                return out;
+            };
+
+            REQUIRE(hex(Utils::ExpandMessageXmd(Bytes(), dst, 0x20)) ==
+                    "68a985b87eb6b46952128911f2a4412bbc302a9d759667f87f7a21d803f07235");
+            REQUIRE(hex(Utils::ExpandMessageXmd(Utils::StringToBytes("abc"), dst, 0x20)) ==
+                    "d8ccab23b5985ccea865c6c97b6e5b8350e794e603b4b97902f53a8a0d605615");
+            REQUIRE(hex(Utils::ExpandMessageXmd(Utils::StringToBytes("abc"), dst, 0x80)) ==
+                    "abba86a6129e366fc877aab32fc4ffc70120d8996c88aee2fe4b32d6c7b6437a"
+                    "647e6c3163d40b76a73cf6a5674ef1d890f95b664ee0afa5359a5c4e07985635"
+                    "bbecbac65d747d3d2da7ec2b8221b17b0ca9dc8a1ac1c07ea6a1e60583e2cb00"
+                    "058e77b7b72a298425cd1b941ad4ec65e8afc50303a22c0f99b0509b4c895f40");
+        }
+
+        THEN("oversized requests should be rejected") {
+            REQUIRE_THROWS(Utils::ExpandMessageXmd(Bytes(), dst, 256 * 32));
+        }
     }
-}
\ No newline at end of file
+}
@@ -54,6 +54,10 @@ SCENARIO("VOPRF protocol", "[VOPRF]") {
                 REQUIRE(p != p2);
             }
 
+            THEN("both execution modes should agree") {
+                REQUIRE(Point::Mul(p, sk, ExecutionMode::SecretInputs) == Point::Mul(p, sk, ExecutionMode::PublicInputs));
+            }
+
             THEN("the point should be evaluatable") {
                 Point p2 = Point::Mul(p, sk);
                 REQUIRE(p2.ToString().size() > 0);
@@ -66,6 +70,114 @@ SCENARIO("VOPRF protocol", "[VOPRF]") {
         }
     }
 
+    GIVEN("Values to put on the wire") {
+        Point p = Point::HashToPoint("wire");
+        uint8_t buf[Pairing::SERIALIZED_SIZE];
+
+        THEN("keys and points should round-trip through fixed-size buffers") {
+            REQUIRE(sk.SerializeTo(buf, sizeof(buf)) == PrivateKey::SERIALIZED_SIZE);
+            REQUIRE(PrivateKey::DeserializeFrom(buf, PrivateKey::SERIALIZED_SIZE) == sk);
+
+            REQUIRE(pk.SerializeTo(buf, sizeof(buf)) == PublicKey::SERIALIZED_SIZE);
+            REQUIRE(PublicKey::DeserializeFrom(buf, PublicKey::SERIALIZED_SIZE) == pk);
+
+            REQUIRE(p.SerializeTo(buf, sizeof(buf)) == Point::SERIALIZED_SIZE);
+            REQUIRE(Point::DeserializeFrom(buf, Point::SERIALIZED_SIZE) == p);
+            REQUIRE(Bytes(buf, buf + Point::SERIALIZED_SIZE) == p.ToBytes());
+        }
+
+        THEN("pairings should round-trip in compressed form") {
+            Pairing e = Pairing::Pair(p, pk);
+            REQUIRE(e.SerializeTo(buf, sizeof(buf)) == Pairing::SERIALIZED_SIZE);
+            REQUIRE(Pairing::DeserializeFrom(buf, sizeof(buf)) == e);
+
+            Pairing one = Pairing::Pair(Point::Mul(p, PrivateKey(mcl::bn::Fr(0))), pk);
+            REQUIRE(Pairing::FromBytes(one.ToBytes()) == one);
+        }
+
+        THEN("short buffers should be rejected") {
+            REQUIRE_THROWS(p.SerializeTo(buf, Point::SERIALIZED_SIZE - 1));
+            REQUIRE_THROWS(Pairing::DeserializeFrom(buf, 10));
+        }
+
+        THEN("vectors of points should round-trip with a length prefix") {
+            vector<Point> points = { p, Point::HashToPoint("a"), Point::HashToPoint("b") };
+            Bytes out(Point::SerializedVectorSize(points.size()));
+            REQUIRE(Point::SerializeVector(points, out.data(), out.size()) == out.size());
+
+            size_t consumed = 0;
+            auto decoded = Point::DeserializeVector(out.data(), out.size(), &consumed);
+            REQUIRE(consumed == out.size());
+            REQUIRE(decoded == points);
+            REQUIRE_THROWS(Point::DeserializeVector(out.data(), out.size() - 1));
+        }
+    }
+
+    GIVEN("Points, public keys and scalars") {
+        vector<Point> points;
+        vector<PublicKey> keys;
+        vector<PrivateKey> scalars;
+        for (int i = 0; i < 40; i++) {
+            points.push_back(Point::HashToPoint("msm-" + std::to_string(i)));
+            keys.push_back(PrivateKey::Keygen().GetPublicKey());
+            scalars.push_back(PrivateKey::Keygen());
+        }
+
+        THEN("MulVec should match the naive sum") {
+            mcl::bn::G1 p;
+            mcl::bn::G2 q;
+            p.clear();
+            q.clear();
+            for (size_t i = 0; i < points.size(); i++) {
+                mcl::bn::G1 t1;
+                mcl::bn::G2 t2;
+                mcl::bn::G1::mul(t1, points[i].GetG1(), scalars[i].GetFr());
+                mcl::bn::G2::mul(t2, keys[i].GetG2(), scalars[i].GetFr());
+                mcl::bn::G1::add(p, p, t1);
+                mcl::bn::G2::add(q, q, t2);
+            }
+            REQUIRE(Point::MulVec(points, scalars) == Point(p));
+            REQUIRE(PublicKey::MulVec(keys, scalars) == PublicKey(q));
+        }
+
+        THEN("a split across workers should give the same sum") {
+            WorkerPool pool(3);
+            vector<Point> many;
+            vector<PrivateKey> ks;
+            for (size_t i = 0; i < 2 * MULVEC_PARALLEL_MIN; i++) {
+                many.push_back(points[i % points.size()]);
+                ks.push_back(scalars[i % scalars.size()]);
+            }
+            mcl::bn::G1 expected;
+            expected.clear();
+            for (size_t i = 0; i < many.size(); i++) {
+                mcl::bn::G1 t;
+                mcl::bn::G1::mul(t, many[i].GetG1(), ks[i].GetFr());
+                mcl::bn::G1::add(expected, expected, t);
+            }
+            REQUIRE(Point::MulVec(many, ks, pool) == Point(expected));
+        }
+
+        THEN("mismatched sizes should be rejected") {
+            scalars.pop_back();
+            REQUIRE_THROWS(Point::MulVec(points, scalars));
+        }
+    }
+
+    GIVEN("Two sides of a pairing equation") {
+        Point p = Point::HashToPoint("pairing");
+        PublicKey base(PublicKey::GetBase());
+
+        THEN("e(sk * P, g2) * e(-P, pk) should be one") {
+            REQUIRE(Pairing::ProductIsOne(Point::Mul(p, sk), base, Point::Neg(p), pk));
+            REQUIRE(Pairing::ProductIsOne(vector<Point>{Point::Mul(p, sk), Point::Neg(p)}, vector<PublicKey>{base, pk}));
+        }
+
+        THEN("an unbalanced product should not be one") {
+            REQUIRE_FALSE(Pairing::ProductIsOne(Point::Mul(p, sk), base, p, pk));
+        }
+    }
+
     GIVEN("A client, server and a message") {
         string m = "hello world";
         Point point = Point::HashToPoint(m);
@@ -88,8 +200,198 @@ SCENARIO("VOPRF protocol", "[VOPRF]") {
                         bool ok = VOPRF::Verify(pk, m, y);
                         REQUIRE(ok);
                     }
+
+                    THEN("a prepared public key should verify it too") {
+                        PreparedPublicKey prepared(pk);
+                        REQUIRE(VOPRF::Verify(prepared, m, y));
+                        REQUIRE_FALSE(VOPRF::Verify(prepared, m + "!", y));
+                    }
                 }
             }
         }
     }
-}
\ No newline at end of file
+
+    GIVEN("A batch of unblinded outputs") {
+        vector<string> msgs;
+        vector<Point> ys;
+        for (int i = 0; i < 16; i++) {
+            msgs.push_back("call-" + std::to_string(i));
+            VOPRF_Blinded blinded = VOPRF::Blind(msgs.back());
+            ys.push_back(VOPRF::Unblind(VOPRF::Evaluate(sk, blinded.x), blinded.r));
+        }
+
+        THEN("the whole batch should verify") {
+            vector<size_t> failed;
+            REQUIRE(VOPRF::VerifyBatch(pk, msgs, ys, &failed));
+            REQUIRE(failed.empty());
+        }
+
+        THEN("the batch should verify against a prepared key") {
+            PreparedPublicKey prepared(pk);
+            REQUIRE(VOPRF::VerifyBatch(prepared, msgs, ys));
+        }
+
+        THEN("an empty batch should verify") {
+            REQUIRE(VOPRF::VerifyBatch(pk, vector<string>{}, vector<Point>{}));
+        }
+
+        WHEN("one output is wrong") {
+            ys[5] = ys[6];
+
+            THEN("the batch should fail and report the bad item") {
+                vector<size_t> failed;
+                REQUIRE_FALSE(VOPRF::VerifyBatch(pk, msgs, ys, &failed));
+                REQUIRE(failed == vector<size_t>{5});
+            }
+        }
+
+        WHEN("a different public key is used") {
+            PublicKey other = PrivateKey::Keygen().GetPublicKey();
+
+            THEN("the batch should fail") {
+                REQUIRE_FALSE(VOPRF::VerifyBatch(other, msgs, ys));
+            }
+        }
+
+        WHEN("the sizes do not match") {
+            ys.pop_back();
+
+            THEN("it should be rejected") {
+                REQUIRE_THROWS(VOPRF::VerifyBatch(pk, msgs, ys));
+            }
+        }
+    }
+
+    GIVEN("A key split into shares") {
+        size_t t = 3, n = 5;
+        auto shares = VOPRF::SplitKey(sk, t, n);
+        string m = "threshold";
+        VOPRF_Blinded blinded = VOPRF::Blind(m);
+
+        THEN("any t partial evaluations should combine to the full evaluation") {
+            vector<VOPRF_PartialEval> partials = {
+                VOPRF::EvaluatePartial(shares[4], blinded.x),
+                VOPRF::EvaluatePartial(shares[1], blinded.x),
+                VOPRF::EvaluatePartial(shares[2], blinded.x),
+            };
+            for (const auto& partial : partials) {
+                REQUIRE(VOPRF::VerifyPartial(shares[partial.index - 1].pk, blinded.x, partial));
+            }
+
+            Point fx = VOPRF::Combine(partials, t);
+            REQUIRE(fx == VOPRF::Evaluate(sk, blinded.x));
+            REQUIRE(VOPRF::Verify(pk, m, VOPRF::Unblind(fx, blinded.r)));
+        }
+
+        THEN("fewer than t partials should not be enough") {
+            vector<VOPRF_PartialEval> partials = {
+                VOPRF::EvaluatePartial(shares[0], blinded.x),
+                VOPRF::EvaluatePartial(shares[1], blinded.x),
+            };
+            REQUIRE_THROWS(VOPRF::Combine(partials, t));
+            REQUIRE(VOPRF::Combine(partials, 2) != VOPRF::Evaluate(sk, blinded.x));
+        }
+
+        THEN("a partial from the wrong share should not verify") {
+            auto partial = VOPRF::EvaluatePartial(shares[0], blinded.x);
+            REQUIRE_FALSE(VOPRF::VerifyPartial(shares[1].pk, blinded.x, partial));
+        }
+
+        THEN("invalid thresholds should be rejected") {
+            REQUIRE_THROWS(VOPRF::SplitKey(sk, 0, n));
+            REQUIRE_THROWS(VOPRF::SplitKey(sk, n + 1, n));
+        }
+    }
+
+    GIVEN("Many messages to blind at once") {
+        vector<string> msgs;
+        for (int i = 0; i < 100; i++) {
+            msgs.push_back("id-" + std::to_string(i));
+        }
+
+        VOPRF_BlindedBatch blinded = VOPRF::BlindBatch(msgs);
+
+        THEN("every message should unblind to the plain evaluation") {
+            REQUIRE(blinded.Size() == msgs.size());
+
+            vector<Point> fxs;
+            for (const auto& x : blinded.xs) {
+                fxs.push_back(VOPRF::Evaluate(sk, x));
+            }
+            vector<Point> ys = VOPRF::UnblindBatch(fxs, blinded);
+
+            for (size_t i = 0; i < msgs.size(); i++) {
+                REQUIRE(ys[i] == Point::Mul(Point::HashToPoint(msgs[i]), sk));
+            }
+            REQUIRE(VOPRF::VerifyBatch(pk, msgs, ys));
+        }
+
+        THEN("mismatched sizes should be rejected") {
+            REQUIRE_THROWS(VOPRF::UnblindBatch(vector<Point>(3), blinded));
+        }
+    }
+
+    GIVEN("Messages hashed to the curve") {
+        string m = "hash to curve";
+
+        THEN("HashToCurve should be deterministic and domain separated") {
+            REQUIRE(Point::HashToCurve(m) == Point::HashToCurve(m));
+            REQUIRE(Point::HashToCurve(m) != Point::HashToCurve(m + "!"));
+            REQUIRE(Point::HashToCurve(m) != Point::HashToCurve(m, "OTHER-DST"));
+            REQUIRE(Point::HashToCurve(m).GetG1().isValid());
+        }
+
+        THEN("the cache should return the same points as HashToPoint") {
+            HashedPointCache cache(2);
+            REQUIRE(cache.Get(m) == Point::HashToPoint(m));
+            REQUIRE(cache.Get(m) == Point::HashToPoint(m));
+            REQUIRE(cache.GetHits() == 1);
+            REQUIRE(cache.GetMisses() == 1);
+
+            cache.Get("a");
+            cache.Get("b");
+            REQUIRE(cache.Size() == 2);
+        }
+
+        THEN("verification should accept a cached or carried-over hash") {
+            PreparedPublicKey prepared(pk);
+            HashedPointCache cache;
+            VOPRF_Blinded blinded = VOPRF::Blind(m);
+            Point y = VOPRF::Unblind(VOPRF::Evaluate(sk, blinded.x), blinded.r);
+
+            REQUIRE(VOPRF::VerifyHashed(prepared, blinded.h, y));
+            REQUIRE_FALSE(VOPRF::VerifyHashed(prepared, Point(), y));
+            REQUIRE_FALSE(VOPRF::VerifyHashed(prepared, Point(), Point()));
+            REQUIRE_FALSE(VOPRF::VerifyHashed(prepared, VOPRF_Blinded(blinded.r, blinded.x).h, y));
+            REQUIRE(VOPRF::Verify(prepared, cache, m, y));
+            REQUIRE(VOPRF::Verify(prepared, cache, m, y));
+            REQUIRE_FALSE(VOPRF::Verify(prepared, cache, m + "!", y));
+        }
+    }
+}
+
+SCENARIO("Curve policies", "[VOPRF]") {
+    GIVEN("The curve this build was configured for") {
+        InitMCL();
+        Point p = Point::HashToPoint("curve");
+
+        THEN("element sizes should follow the field sizes") {
+#ifdef JODI_CURVE_BLS12_381
+            REQUIRE(Point::SERIALIZED_SIZE == 48);
+            REQUIRE(PublicKey::SERIALIZED_SIZE == 96);
+            REQUIRE(PrivateKey::SERIALIZED_SIZE == 32);
+            REQUIRE(Pairing::SERIALIZED_SIZE == 289);
+#else
+            REQUIRE(Point::SERIALIZED_SIZE == 32);
+            REQUIRE(PublicKey::SERIALIZED_SIZE == 64);
+            REQUIRE(PrivateKey::SERIALIZED_SIZE == 32);
+            REQUIRE(Pairing::SERIALIZED_SIZE == 193);
+#endif
+        }
+
+        THEN("encodings should have the policy's sizes") {
+            REQUIRE(p.ToBytes().size() == DefaultCurve::G1_SIZE);
+            REQUIRE(PrivateKey::Keygen().GetPublicKey().ToBytes().size() == DefaultCurve::G2_SIZE);
+        }
+    }
+}